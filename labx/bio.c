@@ -0,0 +1,338 @@
+// Buffer cache.
+//
+// The buffer cache is a linked list of buf structures holding
+// cached copies of disk block contents.  Caching disk blocks
+// in memory reduces the number of disk reads and also provides
+// a synchronization point for disk blocks used by multiple processes.
+//
+// Interface:
+// * To get a buffer for a particular disk block, call bread.
+// * After changing buffer data, call bwrite to write it to disk.
+// * When done with the buffer, call brelse.
+// * Do not use the buffer after calling brelse.
+// * Only one process at a time can use a buffer,
+//     so do not keep them longer than necessary.
+//
+// labx: 按 (dev, blockno) 散列到 NBUCKET 个桶，每个桶一把锁，
+// 命中时只锁自己的桶。LRU 不再挪链表，brelse 记下 ticks，
+// 没命中时在所有桶里找 refcnt 为 0、lastuse 最小的 buf 偷过来。
+// 淘汰由 bcache.lock 串行化：只有拿着它的进程会同时持有两把桶锁，
+// 其他路径最多持有一把，所以不会死锁。
+
+
+#include "types.h"
+#include "param.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "riscv.h"
+#include "defs.h"
+#include "fs.h"
+#include "buf.h"
+
+#define NBUCKET 13
+
+struct bucket {
+  struct spinlock lock;
+  struct buf head;      // 桶里的 buf 组成的双向链表，不分先后
+};
+
+struct {
+  struct spinlock lock; // 淘汰 (把 buf 换到别的桶) 时持有
+  int rainflight;       // labx readahead: 正在读的预读 buf 数，不超过 NRABUF
+  struct buf buf[NBUF];
+  struct bucket bucket[NBUCKET];
+} bcache;
+
+static struct bucket*
+hash(uint dev, uint blockno)
+{
+  return &bcache.bucket[(dev * 31 + blockno) % NBUCKET];
+}
+
+static void
+bdetach(struct buf *b)
+{
+  b->next->prev = b->prev;
+  b->prev->next = b->next;
+}
+
+static void
+battach(struct bucket *bk, struct buf *b)
+{
+  b->next = bk->head.next;
+  b->prev = &bk->head;
+  bk->head.next->prev = b;
+  bk->head.next = b;
+}
+
+void
+binit(void)
+{
+  struct buf *b;
+  struct bucket *bk;
+
+  initlock(&bcache.lock, "bcache");
+  for(bk = bcache.bucket; bk < bcache.bucket+NBUCKET; bk++){
+    initlock(&bk->lock, "bcache.bucket");
+    bk->head.prev = &bk->head;
+    bk->head.next = &bk->head;
+  }
+
+  // 一开始都放在 0 号桶里，用到时再被偷走
+  for(b = bcache.buf; b < bcache.buf+NBUF; b++){
+    initsleeplock(&b->lock, "buffer");
+    battach(&bcache.bucket[0], b);
+  }
+}
+
+// 在桶里找 (dev, blockno)，找到就加引用。调用者持有 bk->lock。
+static struct buf*
+lookup(struct bucket *bk, uint dev, uint blockno)
+{
+  struct buf *b;
+
+  for(b = bk->head.next; b != &bk->head; b = b->next){
+    if(b->dev == dev && b->blockno == blockno){
+      b->refcnt++;
+      return b;
+    }
+  }
+  return 0;
+}
+
+// 去掉一个引用，到 0 时记下时间，供淘汰时比较。
+static void
+brelease(struct buf *b)
+{
+  struct bucket *bk;
+
+  bk = hash(b->dev, b->blockno);
+  acquire(&bk->lock);
+  b->refcnt--;
+  if (b->refcnt == 0) {
+    // no one is waiting for it.
+    b->lastuse = ticks;
+  }
+  release(&bk->lock);
+}
+
+// 没命中时拿 bcache.lock 装入 (dev, blockno)，返回加过引用、
+// 还没锁上的 buf；*fresh 表示是不是刚换进来的。没有空闲 buf 时返回 0。
+static struct buf*
+brecycle(uint dev, uint blockno, int *fresh)
+{
+  struct bucket *bk, *k, *held;
+  struct buf *b, *victim;
+
+  // 只有拿着 bcache.lock 才能往桶里放 buf，所以重查一次之后
+  // 别人不会再把这个块装进来。
+  bk = hash(dev, blockno);
+  acquire(&bcache.lock);
+  acquire(&bk->lock);
+  b = lookup(bk, dev, blockno);
+  release(&bk->lock);
+  if(b){
+    release(&bcache.lock);
+    *fresh = 0;
+    return b;
+  }
+
+  // Recycle the least recently used (LRU) unused buffer.
+  // 扫描时一直拿着当前候选所在桶的锁，保证它不会被别人引用。
+  victim = 0;
+  held = 0;
+  for(k = bcache.bucket; k < bcache.bucket+NBUCKET; k++){
+    acquire(&k->lock);
+    int better = 0;
+    for(b = k->head.next; b != &k->head; b = b->next){
+      if(b->refcnt == 0 && (victim == 0 || b->lastuse < victim->lastuse)){
+        victim = b;
+        better = 1;
+      }
+    }
+    if(better){
+      if(held)
+        release(&held->lock);
+      held = k;
+    } else {
+      release(&k->lock);
+    }
+  }
+  if(victim == 0){
+    release(&bcache.lock);
+    return 0;
+  }
+
+  bdetach(victim);
+  victim->dev = dev;
+  victim->blockno = blockno;
+  victim->valid = 0;
+  victim->refcnt = 1;
+  if(held != bk){
+    release(&held->lock);
+    acquire(&bk->lock);
+  }
+  battach(bk, victim);
+  release(&bk->lock);
+  release(&bcache.lock);
+  *fresh = 1;
+  return victim;
+}
+
+// Look through buffer cache for block on device dev.
+// If not found, allocate a buffer.
+// In either case, return locked buffer.
+static struct buf*
+bget(uint dev, uint blockno)
+{
+  struct bucket *bk;
+  struct buf *b;
+  int fresh;
+
+  bk = hash(dev, blockno);
+  acquire(&bk->lock);
+  b = lookup(bk, dev, blockno);
+  release(&bk->lock);
+
+  // Not cached.
+  if(b == 0 && (b = brecycle(dev, blockno, &fresh)) == 0)
+    panic("bget: no buffers");
+  acquiresleep(&b->lock);
+  return b;
+}
+
+// Return a locked buf with the contents of the indicated block.
+struct buf*
+bread(uint dev, uint blockno)
+{
+  struct buf *b;
+
+  b = bget(dev, blockno);
+  if(!b->valid) {
+    virtio_disk_rw(b, 0);
+    b->valid = 1;
+  }
+  return b;
+}
+
+static void breaddone(struct buf*);
+
+// labx readahead: 不在缓存里的块发一个异步读就返回。
+// 预读的 buf 占一个引用、锁着 sleeplock，读完时 breaddone() 放开；
+// 这期间 bread 同一个块会在 acquiresleep 里等它。
+// 只是排进磁盘队列，发完一批后调用 bkick()。
+// 同时在读的预读最多 NRABUF 个，满了就不预读，不管有多少个进程在顺序读，
+// 预读占住的 buf 都不会超过 NBUF 里为它多留的部分，bget() 不会因为预读找不到 buf。
+void
+breadahead(uint dev, uint blockno)
+{
+  struct bucket *bk;
+  struct buf *b;
+  int fresh;
+
+  if(__sync_fetch_and_add(&bcache.rainflight, 1) >= NRABUF){
+    __sync_fetch_and_sub(&bcache.rainflight, 1);
+    return;
+  }
+
+  bk = hash(dev, blockno);
+  acquire(&bk->lock);
+  b = lookup(bk, dev, blockno);
+  if(b){
+    // 已经在缓存里或者正在读
+    b->refcnt--;
+    release(&bk->lock);
+    goto skip;
+  }
+  release(&bk->lock);
+
+  // 缓存都被占着就不预读了
+  if((b = brecycle(dev, blockno, &fresh)) == 0)
+    goto skip;
+  if(!fresh){
+    brelease(b);
+    goto skip;
+  }
+  acquiresleep(&b->lock);
+  if(b->valid){
+    // 在 acquiresleep 之前被别人 bread 读进来了
+    brelse(b);
+    goto skip;
+  }
+  virtio_disk_submit(b, 0, breaddone);
+  return;
+
+skip:
+  __sync_fetch_and_sub(&bcache.rainflight, 1);
+}
+
+// labx readahead: 预读完成，在 virtio_disk_intr() 里调用。
+static void
+breaddone(struct buf *b)
+{
+  b->valid = 1;
+  releasesleep(&b->lock);
+  brelease(b);
+  __sync_fetch_and_sub(&bcache.rainflight, 1);
+}
+
+// Write b's contents to disk.  Must be locked.
+void
+bwrite(struct buf *b)
+{
+  if(!holdingsleep(&b->lock))
+    panic("bwrite");
+  virtio_disk_rw(b, 1);
+}
+
+// labx: 异步写，b 一直锁着，用 bwait() 等它写完再 brelse()。
+void
+bwrite_async(struct buf *b)
+{
+  if(!holdingsleep(&b->lock))
+    panic("bwrite_async");
+  virtio_disk_submit(b, 1, 0);
+}
+
+void
+bwait(struct buf *b)
+{
+  virtio_disk_wait(b);
+}
+
+// labx: breadahead()、bwrite_async() 只排队，攒一批之后调用这个通知磁盘
+void
+bkick(void)
+{
+  virtio_disk_kick();
+}
+
+// Release a locked buffer.
+void
+brelse(struct buf *b)
+{
+  if(!holdingsleep(&b->lock))
+    panic("brelse");
+
+  releasesleep(&b->lock);
+  brelease(b);
+}
+
+// refcnt > 0 的 buf 不会换桶，所以可以直接按 blockno 找锁
+void
+bpin(struct buf *b) {
+  struct bucket *bk = hash(b->dev, b->blockno);
+
+  acquire(&bk->lock);
+  b->refcnt++;
+  release(&bk->lock);
+}
+
+void
+bunpin(struct buf *b) {
+  struct bucket *bk = hash(b->dev, b->blockno);
+
+  acquire(&bk->lock);
+  b->refcnt--;
+  release(&bk->lock);
+}
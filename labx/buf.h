@@ -0,0 +1,15 @@
+struct buf {
+  int valid;   // has data been read from disk?
+  int disk;    // does disk "own" buf?
+  void (*done)(struct buf *); // labx 异步请求完成时在中断里调用
+  int qwrite;  // labx 排队的是写请求
+  struct buf *qnext; // labx 磁盘队列里的下一个，发出去以后是同一个请求里的下一块
+  uint dev;
+  uint blockno;
+  struct sleeplock lock;
+  uint refcnt;
+  uint lastuse; // labx 最后一次 brelse 的 ticks，淘汰时找最小的
+  struct buf *prev; // labx 所在散列桶的链表
+  struct buf *next;
+  uchar data[BSIZE];
+};
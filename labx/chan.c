@@ -0,0 +1,125 @@
+#include "kernel/types.h"
+#include "kernel/riscv.h"
+#include "user/user.h"
+
+// labx chan
+// 单生产者单消费者的环形缓冲区，放在 chan_create() 得到的共享页里。
+// 收发都在用户态完成，只有满了或空了才用 futex 进内核睡眠。
+// 页是 fork 时共享的：先 chan_open()，再 fork，一边只发一边只收。
+//
+// 睡眠的一方先置 rwait/wwait，再记下 seq，最后检查条件；
+// 唤醒的一方先改 head/tail，再看 rwait/wwait，需要时把 seq 加一并 futex_wake。
+// 两边中间都有完整的内存屏障，所以唤醒要么被看到，要么 futex_wait 不会睡下去。
+
+static void
+chan_wake(int *seq)
+{
+  __sync_fetch_and_add(seq, 1);
+  futex_wake(seq, 1);
+}
+
+#define CHANSIZE 2048
+
+struct chan {
+  volatile uint head;     // 生产者写到的位置
+  volatile uint tail;     // 消费者读到的位置
+  volatile int rwait;     // 消费者可能在睡眠
+  volatile int wwait;     // 生产者可能在睡眠
+  int rseq;               // 消费者睡在这个 futex 上，唤醒前加一
+  int wseq;               // 生产者睡在这个 futex 上，唤醒前加一
+  volatile int closed;    // 生产者不会再发了
+  char data[CHANSIZE];
+};
+
+struct chan*
+chan_open(void)
+{
+  return chan_create();
+}
+
+// 把 buf 的 n 字节发出去，必要时等待空间，返回 n
+int
+chan_send(struct chan *c, const void *buf, int n)
+{
+  const char *s = buf;
+  uint head, off, m;
+  int i, seq;
+
+  for(i = 0; i < n; i += m){
+    head = c->head;
+    while((m = CHANSIZE - (head - c->tail)) == 0){
+      c->wwait = 1;
+      __sync_synchronize();
+      seq = c->wseq;
+      __sync_synchronize();
+      if(head - c->tail == CHANSIZE)
+        futex_wait(&c->wseq, seq);
+      c->wwait = 0;
+    }
+    off = head % CHANSIZE;
+    if(m > CHANSIZE - off)
+      m = CHANSIZE - off;
+    if(m > n - i)
+      m = n - i;
+    memcpy(c->data + off, s + i, m);
+    __sync_synchronize();
+    c->head = head + m;
+    __sync_synchronize();
+    if(c->rwait)
+      chan_wake(&c->rseq);
+  }
+  return n;
+}
+
+// 最多收 n 字节到 buf，没有数据时等待；返回收到的字节数，
+// 对方 chan_close() 并且已经收完时返回 0
+int
+chan_recv(struct chan *c, void *buf, int n)
+{
+  char *d = buf;
+  uint tail, off, m, avail;
+  int i, seq;
+
+  tail = c->tail;
+  while((avail = c->head - tail) == 0){
+    if(c->closed){
+      // 看到 head 之后对方可能又发了数据才 close，重读一次 head
+      __sync_synchronize();
+      if(c->head == tail)
+        return 0;
+      continue;
+    }
+    c->rwait = 1;
+    __sync_synchronize();
+    seq = c->rseq;
+    __sync_synchronize();
+    if(c->head == tail && !c->closed)
+      futex_wait(&c->rseq, seq);
+    c->rwait = 0;
+  }
+  __sync_synchronize();
+  for(i = 0; i < n && avail > 0; i += m, avail -= m){
+    off = (tail + i) % CHANSIZE;
+    m = CHANSIZE - off;
+    if(m > avail)
+      m = avail;
+    if(m > n - i)
+      m = n - i;
+    memcpy(d + i, c->data + off, m);
+  }
+  __sync_synchronize();
+  c->tail = tail + i;
+  __sync_synchronize();
+  if(c->wwait)
+    chan_wake(&c->wseq);
+  return i;
+}
+
+// 生产者说不再发了，正在等的消费者醒来后收完剩下的数据再返回 0
+void
+chan_close(struct chan *c)
+{
+  c->closed = 1;
+  __sync_synchronize();
+  chan_wake(&c->rseq);
+}
@@ -0,0 +1,177 @@
+#include "kernel/types.h"
+#include "kernel/riscv.h"
+#include "user/user.h"
+
+// labx clone: clone()/join() 的测试
+
+#define NTHREAD 4
+#define NITER 1000
+
+volatile int counter;
+volatile int stop;
+volatile char *shared;
+
+void
+incr(void *arg)
+{
+  for(int i = 0; i < NITER; i++)
+    __sync_fetch_and_add(&counter, 1);
+}
+
+// 多个线程累加同一个全局变量
+void
+testshare()
+{
+  int i;
+
+  counter = 0;
+  for(i = 0; i < NTHREAD; i++){
+    if(thread_create(incr, 0) < 0){
+      printf("clonetest: thread_create failed\n");
+      exit(1);
+    }
+  }
+  for(i = 0; i < NTHREAD; i++){
+    if(thread_join() < 0){
+      printf("clonetest: thread_join failed\n");
+      exit(1);
+    }
+  }
+  if(thread_join() != -1){
+    printf("clonetest: FAIL join with no threads\n");
+    exit(1);
+  }
+  if(counter != NTHREAD*NITER){
+    printf("clonetest: FAIL counter %d instead of %d\n", counter, NTHREAD*NITER);
+    exit(1);
+  }
+}
+
+void
+grow(void *arg)
+{
+  char *p = sbrk(PGSIZE);
+
+  if(p == (char*)-1)
+    exit(1);
+  p[0] = 'x';
+  shared = p;
+}
+
+struct mutex m;
+
+void
+lockedincr(void *arg)
+{
+  for(int i = 0; i < NITER; i++){
+    mutex_lock(&m);
+    counter = counter + 1;
+    mutex_unlock(&m);
+  }
+}
+
+// labx futex: 用 mutex 保护非原子的累加
+void
+testmutex()
+{
+  int i;
+
+  counter = 0;
+  mutex_init(&m);
+  for(i = 0; i < NTHREAD; i++)
+    thread_create(lockedincr, 0);
+  for(i = 0; i < NTHREAD; i++)
+    thread_join();
+  if(counter != NTHREAD*NITER){
+    printf("clonetest: FAIL mutex counter %d instead of %d\n", counter, NTHREAD*NITER);
+    exit(1);
+  }
+}
+
+// 线程里 sbrk 得到的内存主线程也能看到
+void
+testsbrk()
+{
+  shared = 0;
+  if(thread_create(grow, 0) < 0){
+    printf("clonetest: thread_create failed\n");
+    exit(1);
+  }
+  thread_join();
+  if(shared == 0 || shared[0] != 'x'){
+    printf("clonetest: FAIL sbrk not shared\n");
+    exit(1);
+  }
+}
+
+void
+spin(void *arg)
+{
+  while(!stop)
+    ;
+}
+
+// 别的线程在跑的时候缩小地址空间 (TLB shootdown)
+void
+testshrink()
+{
+  int i;
+  char *p;
+
+  stop = 0;
+  for(i = 0; i < NTHREAD; i++)
+    thread_create(spin, 0);
+  for(i = 0; i < 10; i++){
+    if((p = sbrk(4*PGSIZE)) == (char*)-1){
+      printf("clonetest: sbrk failed\n");
+      exit(1);
+    }
+    p[0] = 1;
+    sbrk(-4*PGSIZE);
+  }
+  stop = 1;
+  for(i = 0; i < NTHREAD; i++)
+    thread_join();
+}
+
+void
+forker(void *arg)
+{
+  int pid, status;
+
+  if((pid = fork()) == 0)
+    exit(7);
+  if(wait(&status) != pid || status != 7)
+    exit(1);
+  counter = 1;
+}
+
+// wait() 不回收线程，线程里可以 fork/wait
+void
+testwait()
+{
+  counter = 0;
+  thread_create(forker, 0);
+  if(wait(0) != -1){
+    printf("clonetest: FAIL wait reaped a thread\n");
+    exit(1);
+  }
+  thread_join();
+  if(counter != 1){
+    printf("clonetest: FAIL fork in thread\n");
+    exit(1);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf("clonetest: start\n");
+  testshare();
+  testmutex();
+  testsbrk();
+  testshrink();
+  testwait();
+  printf("clonetest: OK\n");
+  exit(0);
+}
@@ -0,0 +1,175 @@
+// labx dcache
+// 名字缓存：(dev, 父目录 inum, name) -> 子 inum 和目录项的偏移，
+// inum 为 0 的负项记下名字不存在，反复 stat/open 不存在的文件也不用扫目录。
+//
+// 只有 dirlookup()/dirlink() 和 sys_unlink() 会用，它们都持有父目录的
+// inode 锁，所以同一个目录的查找、填入和失效是串行的，缓存和目录内容一致；
+// 目录 inode 被释放时 dcpurge() 丢掉它下面的所有项，免得 inum 重用后查到旧的。
+//
+// 按 (dev, pinum, name) 散列到 NDBUCKET 个桶，每个桶固定 NDWAY 项，
+// 一把锁，自己的 LRU 链表：命中挪到表头，放新项时从表尾挤掉最久没用的。
+// 任何路径最多持有一把桶锁，锁里不睡眠。
+
+#include "types.h"
+#include "param.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "defs.h"
+#include "fs.h"
+#include "dcache.h"
+
+#define NDBUCKET 31
+#define NDWAY    8
+
+struct dentry {
+  int valid;
+  uint dev;
+  uint pinum;           // 父目录
+  char name[DIRSIZ];
+  uint inum;            // 0 表示名字不存在
+  uint off;             // 目录项在父目录里的偏移，inum 不为 0 时有效
+  struct dentry *prev;  // LRU，head.next 是最近用过的
+  struct dentry *next;
+};
+
+struct dbucket {
+  struct spinlock lock;
+  struct dentry head;
+  struct dentry ent[NDWAY];
+  struct dcstat st;
+};
+
+static struct dbucket dcache[NDBUCKET];
+
+static struct dbucket*
+dchash(uint dev, uint pinum, char *name)
+{
+  return &dcache[(dirhash(name) + pinum * 31 + dev) % NDBUCKET];
+}
+
+static void
+dcdetach(struct dentry *d)
+{
+  d->next->prev = d->prev;
+  d->prev->next = d->next;
+}
+
+static void
+dcattach(struct dbucket *bk, struct dentry *d)
+{
+  d->next = bk->head.next;
+  d->prev = &bk->head;
+  bk->head.next->prev = d;
+  bk->head.next = d;
+}
+
+void
+dcinit(void)
+{
+  struct dbucket *bk;
+  struct dentry *d;
+
+  for(bk = dcache; bk < dcache+NDBUCKET; bk++){
+    initlock(&bk->lock, "dcache");
+    bk->head.prev = &bk->head;
+    bk->head.next = &bk->head;
+    for(d = bk->ent; d < bk->ent+NDWAY; d++)
+      dcattach(bk, d);
+  }
+}
+
+// 在桶里找 name，调用者持有 bk->lock。
+static struct dentry*
+dcfind(struct dbucket *bk, uint dev, uint pinum, char *name)
+{
+  struct dentry *d;
+
+  for(d = bk->head.next; d != &bk->head; d = d->next)
+    if(d->valid && d->dev == dev && d->pinum == pinum && strncmp(d->name, name, DIRSIZ) == 0)
+      return d;
+  return 0;
+}
+
+// 命中返回 1，*inum 为 0 表示名字不存在。调用者持有父目录的锁。
+int
+dclookup(uint dev, uint pinum, char *name, uint *inum, uint *off)
+{
+  struct dbucket *bk;
+  struct dentry *d;
+
+  bk = dchash(dev, pinum, name);
+  acquire(&bk->lock);
+  if((d = dcfind(bk, dev, pinum, name)) == 0){
+    bk->st.misses++;
+    release(&bk->lock);
+    return 0;
+  }
+  dcdetach(d);
+  dcattach(bk, d);
+  *inum = d->inum;
+  *off = d->off;
+  if(d->inum)
+    bk->st.hits++;
+  else
+    bk->st.neghits++;
+  release(&bk->lock);
+  return 1;
+}
+
+// 记下 name 现在的结果：扫过目录之后、dirlink() 写入之后、
+// unlink 清掉目录项之后 (inum 为 0) 调用。调用者持有父目录的锁。
+void
+dcenter(uint dev, uint pinum, char *name, uint inum, uint off)
+{
+  struct dbucket *bk;
+  struct dentry *d;
+
+  bk = dchash(dev, pinum, name);
+  acquire(&bk->lock);
+  if((d = dcfind(bk, dev, pinum, name)) == 0){
+    d = bk->head.prev;    // 表尾，最久没用
+    if(d->valid)
+      bk->st.evicts++;
+    d->valid = 1;
+    d->dev = dev;
+    d->pinum = pinum;
+    strncpy(d->name, name, DIRSIZ);
+  }
+  d->inum = inum;
+  d->off = off;
+  dcdetach(d);
+  dcattach(bk, d);
+  release(&bk->lock);
+}
+
+// 目录 (dev, pinum) 被释放了，丢掉以它为父目录的项。
+void
+dcpurge(uint dev, uint pinum)
+{
+  struct dbucket *bk;
+  struct dentry *d;
+
+  for(bk = dcache; bk < dcache+NDBUCKET; bk++){
+    acquire(&bk->lock);
+    for(d = bk->ent; d < bk->ent+NDWAY; d++)
+      if(d->valid && d->dev == dev && d->pinum == pinum)
+        d->valid = 0;
+    release(&bk->lock);
+  }
+}
+
+void
+dcache_stat(struct dcstat *st)
+{
+  struct dbucket *bk;
+
+  memset(st, 0, sizeof(*st));
+  for(bk = dcache; bk < dcache+NDBUCKET; bk++){
+    acquire(&bk->lock);
+    st->hits += bk->st.hits;
+    st->neghits += bk->st.neghits;
+    st->misses += bk->st.misses;
+    st->evicts += bk->st.evicts;
+    release(&bk->lock);
+  }
+}
@@ -0,0 +1,8 @@
+// labx dcache
+// 名字缓存的计数，从开机开始累计
+struct dcstat {
+  uint64 hits;      // 命中，名字存在
+  uint64 neghits;   // 命中，名字不存在 (负项)
+  uint64 misses;    // 没命中，扫了目录
+  uint64 evicts;    // 为了放新项挤掉的旧项
+};
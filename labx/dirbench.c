@@ -0,0 +1,125 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+#include "user/user.h"
+
+// labx hashed directory: 大目录里按名字查找的开销
+// 在 dbdir 里给同一个文件建 n 个硬链接 (不占 inode)，
+// 然后按随机顺序 stat 每个名字、stat 同样多不存在的名字，最后全部删掉。
+// 默认 dbdir 是散列目录，-l 用普通的线性目录对比。
+
+#define MAXN    12000
+
+char *dir = "dbdir";
+char *file = "dbfile";
+
+// dbdir/<c>NNNNN
+void
+mkname(char *buf, char c, int i)
+{
+  int k, j;
+
+  strcpy(buf, dir);
+  k = strlen(buf);
+  buf[k++] = '/';
+  buf[k++] = c;
+  buf[k+5] = 0;
+  for(j = k + 4; j >= k; j--, i /= 10)
+    buf[j] = '0' + i % 10;
+}
+
+void
+report(char *what, int n, uint64 t)
+{
+  printf("  %s: %l us, %l.%l us/op\n", what, t * 1000000 / TIMEHZ,
+         t * 1000000 / TIMEHZ / n, t * 10000000 / TIMEHZ / n % 10);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char name[32];
+  struct stat st;
+  int n, i, fd, linear, nbucket;
+  uint x;
+  uint64 t;
+
+  linear = 0;
+  if(argc > 1 && strcmp(argv[1], "-l") == 0){
+    linear = 1;
+    argc--;
+    argv++;
+  }
+  n = argc > 1 ? atoi(argv[1]) : 10000;
+  if(argc > 2 || n < 1 || n > MAXN){
+    fprintf(2, "usage: dirbench [-l] [n(1-%d)]\n", MAXN);
+    exit(1);
+  }
+
+  if((fd = open(file, O_CREATE|O_WRONLY)) < 0){
+    printf("dirbench: create %s failed\n", file);
+    exit(1);
+  }
+  close(fd);
+  // 每个桶装 DPB-1 项，按 3/4 满估算桶数
+  nbucket = n / ((DPB - 1) * 3 / 4) + 1;
+  if(nbucket > MAXFILE)
+    nbucket = MAXFILE;
+  if((linear ? mkdir(dir) : hmkdir(dir, nbucket)) < 0){
+    printf("dirbench: mkdir %s failed (left over from last run?)\n", dir);
+    exit(1);
+  }
+  if(linear)
+    printf("dirbench: %d names, linear directory\n", n);
+  else
+    printf("dirbench: %d names, hashed directory with %d buckets\n", n, nbucket);
+
+  t = rdtime();
+  for(i = 0; i < n; i++){
+    mkname(name, 'e', i);
+    if(link(file, name) < 0){
+      printf("dirbench: link %s failed\n", name);
+      exit(1);
+    }
+  }
+  report("link", n, rdtime() - t);
+
+  x = 1;
+  t = rdtime();
+  for(i = 0; i < n; i++){
+    x = x * 1103515245 + 12345;
+    mkname(name, 'e', (x >> 8) % n);
+    if(stat(name, &st) < 0){
+      printf("dirbench: stat %s failed\n", name);
+      exit(1);
+    }
+  }
+  report("stat", n, rdtime() - t);
+
+  t = rdtime();
+  for(i = 0; i < n; i++){
+    mkname(name, 'm', i);
+    if(stat(name, &st) >= 0){
+      printf("dirbench: %s should not exist\n", name);
+      exit(1);
+    }
+  }
+  report("stat missing", n, rdtime() - t);
+
+  t = rdtime();
+  for(i = 0; i < n; i++){
+    mkname(name, 'e', i);
+    if(unlink(name) < 0){
+      printf("dirbench: unlink %s failed\n", name);
+      exit(1);
+    }
+  }
+  report("unlink", n, rdtime() - t);
+
+  if(unlink(dir) < 0 || unlink(file) < 0){
+    printf("dirbench: cleanup failed\n");
+    exit(1);
+  }
+  exit(0);
+}
@@ -0,0 +1,78 @@
+// labx eventfd
+// 只有一个 64 位计数器的文件：write 把 8 字节的值加到计数器上，
+// read 等到计数器非 0，取走它并清零。计数器就放在 struct file 里，
+// 没有缓冲区也不用另外分配，是进程之间最轻的唤醒方式。
+
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "poll.h"
+
+// 所有 eventfd 的计数器共用一把锁
+struct spinlock eventlock;
+
+void
+eventinit(void)
+{
+  initlock(&eventlock, "event");
+}
+
+int
+eventread(struct file *f, uint64 addr, int n)
+{
+  struct proc *p = myproc();
+  uint64 v;
+
+  if(n < sizeof(v))
+    return -1;
+  acquire(&eventlock);
+  while(f->count == 0){
+    if(p->killed){
+      release(&eventlock);
+      return -1;
+    }
+    sleep(&f->count, &eventlock);
+  }
+  v = f->count;
+  f->count = 0;
+  release(&eventlock);
+  if(copyout(p->pagetable, addr, (char*)&v, sizeof(v)) < 0)
+    return -1;
+  return sizeof(v);
+}
+
+int
+eventwrite(struct file *f, uint64 addr, int n)
+{
+  uint64 v;
+
+  if(n < sizeof(v) || copyin(myproc()->pagetable, (char*)&v, addr, sizeof(v)) < 0)
+    return -1;
+  if(v == 0)
+    return sizeof(v);
+  acquire(&eventlock);
+  f->count += v;
+  wakeup(&f->count);
+  pollwakeup(&f->pollq);
+  release(&eventlock);
+  return sizeof(v);
+}
+
+int
+eventpoll(struct file *f, struct pollent *e)
+{
+  int r = POLLOUT;
+
+  acquire(&eventlock);
+  pollwait(&f->pollq, e);
+  if(f->count)
+    r |= POLLIN;
+  release(&eventlock);
+  return r;
+}
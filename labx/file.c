@@ -0,0 +1,489 @@
+//
+// Support functions for system calls that involve file descriptors.
+//
+
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "fs.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "stat.h"
+#include "proc.h"
+#include "uio.h"
+#include "poll.h"
+
+struct devsw devsw[NDEV];
+struct {
+  struct spinlock lock;
+  struct file file[NFILE];
+} ftable;
+
+void
+fileinit(void)
+{
+  initlock(&ftable.lock, "ftable");
+}
+
+// Allocate a file structure.
+struct file*
+filealloc(void)
+{
+  struct file *f;
+
+  acquire(&ftable.lock);
+  for(f = ftable.file; f < ftable.file + NFILE; f++){
+    if(f->ref == 0){
+      f->ref = 1;
+      release(&ftable.lock);
+      return f;
+    }
+  }
+  release(&ftable.lock);
+  return 0;
+}
+
+// Increment ref count for file f.
+struct file*
+filedup(struct file *f)
+{
+  acquire(&ftable.lock);
+  if(f->ref < 1)
+    panic("filedup");
+  f->ref++;
+  release(&ftable.lock);
+  return f;
+}
+
+// Close file f.  (Decrement ref count, close when reaches 0.)
+void
+fileclose(struct file *f)
+{
+  struct file ff;
+
+  acquire(&ftable.lock);
+  if(f->ref < 1)
+    panic("fileclose");
+  if(--f->ref > 0){
+    release(&ftable.lock);
+    return;
+  }
+  ff = *f;
+  f->ref = 0;
+  f->type = FD_NONE;
+  release(&ftable.lock);
+
+  if(ff.type == FD_PIPE){
+    pipeclose(ff.pipe, ff.writable);
+  } else if(ff.type == FD_INODE || ff.type == FD_DEVICE){
+    begin_op();
+    iput(ff.ip);
+    end_op();
+  }
+}
+
+// Get metadata about file f.
+// addr is a user virtual address, pointing to a struct stat.
+int
+filestat(struct file *f, uint64 addr)
+{
+  struct proc *p = myproc();
+  struct stat st;
+  
+  if(f->type == FD_INODE || f->type == FD_DEVICE){
+    ilock(f->ip);
+    stati(f->ip, &st);
+    iunlock(f->ip);
+    if(copyout(p->pagetable, addr, (char *)&st, sizeof(st)) < 0)
+      return -1;
+    return 0;
+  }
+  return -1;
+}
+
+// Read from file f.
+// addr is a user virtual address.
+int
+fileread(struct file *f, uint64 addr, int n)
+{
+  int r = 0;
+
+  if(f->readable == 0)
+    return -1;
+
+  if(f->type == FD_PIPE){
+    r = piperead(f->pipe, addr, n);
+  } else if(f->type == FD_DEVICE){
+    if(f->major < 0 || f->major >= NDEV || !devsw[f->major].read)
+      return -1;
+    r = devsw[f->major].read(1, addr, n);
+  } else if(f->type == FD_INODE){
+    ilock(f->ip);
+    if((r = readi(f->ip, 1, addr, f->off, n)) > 0)
+      f->off += r;
+    iunlock(f->ip);
+  } else if(f->type == FD_EVENT){
+    r = eventread(f, addr, n);
+  } else {
+    panic("fileread");
+  }
+
+  return r;
+}
+
+// 把 inode 写入拆成若干个不超过 log 容量的事务。
+// user_src 为 1 时 src 是用户地址，否则是内核地址。
+static int
+inodewrite(struct file *f, int user_src, uint64 src, int n)
+{
+  int r = 0;
+
+  // write a few blocks at a time to avoid exceeding
+  // the maximum log transaction size, including
+  // i-node, indirect block, allocation blocks,
+  // and 2 blocks of slop for non-aligned writes.
+  // this really belongs lower down, since writei()
+  // might be writing a device like the console.
+  // labx group commit: 一个事务预留日志的一半，日志越大一次写得越多
+  int nb = logopblocks();
+  int max = ((nb-1-1-2) / 2) * BSIZE;
+  int i = 0;
+  while(i < n){
+    int n1 = n - i;
+    if(n1 > max)
+      n1 = max;
+
+    begin_opn(nb);
+    ilock(f->ip);
+    if ((r = writei(f->ip, user_src, src + i, f->off, n1)) > 0)
+      f->off += r;
+    iunlock(f->ip);
+    end_opn(nb);
+
+    if(r != n1){
+      // error from writei
+      break;
+    }
+    i += r;
+  }
+  return i == n ? n : -1;
+}
+
+// Write to file f.
+// addr is a user virtual address.
+int
+filewrite(struct file *f, uint64 addr, int n)
+{
+  int ret = 0;
+
+  if(f->writable == 0)
+    return -1;
+
+  if(f->type == FD_PIPE){
+    ret = pipewrite(f->pipe, addr, n);
+  } else if(f->type == FD_DEVICE){
+    if(f->major < 0 || f->major >= NDEV || !devsw[f->major].write)
+      return -1;
+    ret = devsw[f->major].write(1, addr, n);
+  } else if(f->type == FD_INODE){
+    ret = inodewrite(f, 1, addr, n);
+  } else if(f->type == FD_EVENT){
+    ret = eventwrite(f, addr, n);
+  } else {
+    panic("filewrite");
+  }
+
+  return ret;
+}
+
+// labx splice
+// 把内核地址 src 开始的 n 字节写到 out，返回写了多少，出错返回 -1
+static int
+kwrite(struct file *out, char *src, int n)
+{
+  int i, m;
+  char *dst;
+
+  if(out->type == FD_PIPE){
+    for(i = 0; i < n; i += m){
+      if((m = pipe_wbegin(out->pipe, n - i, &dst)) < 0)
+        return i > 0 ? i : -1;
+      memmove(dst, src + i, m);
+      pipe_wend(out->pipe, m);
+    }
+    return n;
+  } else if(out->type == FD_DEVICE){
+    if(out->major < 0 || out->major >= NDEV || !devsw[out->major].write)
+      return -1;
+    return devsw[out->major].write(0, (uint64)src, n);
+  } else if(out->type == FD_INODE){
+    return inodewrite(out, 0, (uint64)src, n);
+  }
+  return -1;
+}
+
+// labx splice
+// 在内核里把最多 n 字节从 in 搬到 out，不经过用户内存：
+//   pipe -> pipe：两边都占住，直接从一个 pipe 的页拷到另一个，一次最多拷 out 的空闲空间
+//   inode -> pipe：readi() 从 buffer cache 直接拷进 pipe 的页
+//   pipe -> inode/设备，inode -> inode/设备：经过一个内核页
+// 占着 in 的读端 (rbusy) 时不能睡眠等 out：那期间 in 上别的 read 都要等，
+// 要先读 in 才能腾出 out 的进程就会死锁。
+// 返回搬了多少字节，in 到了文件尾或者 pipe 写端已关闭返回 0，出错返回 -1。
+// 和 read 一样可能少于 n：in 是 pipe 时只等第一段数据。
+int
+filesplice(struct file *in, struct file *out, int n)
+{
+  int done, m, r;
+  char *p, *q;
+
+  if(in->readable == 0 || out->writable == 0 || n < 0)
+    return -1;
+  if(in->type == FD_PIPE && out->type == FD_PIPE && in->pipe == out->pipe)
+    return -1;
+
+  done = 0;
+  if(in->type == FD_PIPE && out->type == FD_PIPE){
+    while(done < n){
+      // 先等 out 有空间，再不等待地从 in 取最多这么多
+      if((m = pipe_wbegin(out->pipe, n - done, &q)) < 0)
+        return done > 0 ? done : -1;
+      if((r = pipe_rbegin(in->pipe, m, &p, 0)) > 0){
+        memmove(q, p, r);
+        pipe_rend(in->pipe, r);
+      }
+      pipe_wend(out->pipe, r > 0 ? r : 0);
+      if(r < 0)
+        return done > 0 ? done : -1;
+      if(r > 0){
+        done += r;
+        continue;
+      }
+      if(done > 0)
+        break;
+      // in 暂时没有数据：不占 out，等到 in 有数据 (或写端关闭) 再来
+      if((r = pipe_rbegin(in->pipe, 1, &p, 1)) <= 0)
+        return r;
+      pipe_rend(in->pipe, 0);
+    }
+    return done;
+  }
+
+  if(in->type != FD_INODE && in->type != FD_PIPE)
+    return -1;    // 设备还是用 read/write
+
+  if(out->type == FD_PIPE){
+    while(done < n){
+      if((m = pipe_wbegin(out->pipe, n - done, &p)) < 0)
+        return done > 0 ? done : -1;
+      ilock(in->ip);
+      if((r = readi(in->ip, 0, (uint64)p, in->off, m)) > 0)
+        in->off += r;
+      iunlock(in->ip);
+      pipe_wend(out->pipe, r > 0 ? r : 0);
+      if(r <= 0)
+        break;
+      done += r;
+    }
+    return done;
+  }
+
+  if((p = kalloc()) == 0)
+    return -1;
+  while(done < n){
+    m = n - done;
+    if(m > PGSIZE)
+      m = PGSIZE;
+    if(in->type == FD_PIPE){
+      // 先拷出来放开 in，再去写可能要等的 out
+      if((r = pipe_rbegin(in->pipe, m, &q, done == 0)) > 0){
+        memmove(p, q, r);
+        pipe_rend(in->pipe, r);
+      }
+      if(r < 0 && done == 0)
+        done = -1;
+    } else {
+      ilock(in->ip);
+      if((r = readi(in->ip, 0, (uint64)p, in->off, m)) > 0)
+        in->off += r;
+      iunlock(in->ip);
+    }
+    if(r <= 0)
+      break;
+    if((r = kwrite(out, p, r)) < 0){
+      if(done == 0)
+        done = -1;
+      break;
+    }
+    done += r;
+  }
+  kfree(p);
+  return done;
+}
+
+// labx readv/writev
+// iov 已经由 sys_readv 拷进内核，地址都是用户地址。
+// 和 read 一样可能少读：遇到文件尾、pipe 里暂时没有更多数据或终端读到一行就返回。
+int
+filereadv(struct file *f, struct iovec *iov, int niov)
+{
+  struct proc *pr = myproc();
+  int i, r, m, total;
+  char *p;
+
+  if(f->readable == 0)
+    return -1;
+
+  total = 0;
+  if(f->type == FD_PIPE){
+    // 只有第一段会等数据，后面有多少拷多少
+    for(i = 0; i < niov; i++){
+      for(r = 0; r < iov[i].iov_len; r += m){
+        m = pipe_rbegin(f->pipe, iov[i].iov_len - r, &p, total == 0);
+        if(m <= 0)
+          return total > 0 ? total : m;
+        if(copyout(pr->pagetable, (uint64)iov[i].iov_base + r, p, m) < 0){
+          pipe_rend(f->pipe, 0);
+          return total > 0 ? total : -1;
+        }
+        pipe_rend(f->pipe, m);
+        total += m;
+      }
+    }
+  } else if(f->type == FD_DEVICE){
+    if(f->major < 0 || f->major >= NDEV || !devsw[f->major].read)
+      return -1;
+    for(i = 0; i < niov; i++){
+      r = devsw[f->major].read(1, (uint64)iov[i].iov_base, iov[i].iov_len);
+      if(r < 0)
+        return total > 0 ? total : -1;
+      total += r;
+      if(r < iov[i].iov_len)
+        break;
+    }
+  } else if(f->type == FD_INODE){
+    // 整个数组只锁一次 inode
+    ilock(f->ip);
+    for(i = 0; i < niov; i++){
+      r = readi(f->ip, 1, (uint64)iov[i].iov_base, f->off, iov[i].iov_len);
+      if(r > 0){
+        f->off += r;
+        total += r;
+      }
+      if(r < iov[i].iov_len)
+        break;
+    }
+    iunlock(f->ip);
+  } else if(f->type == FD_EVENT){
+    return -1;
+  } else {
+    panic("filereadv");
+  }
+  return total;
+}
+
+// labx readv/writev
+// 写 inode 时把相邻的段凑进同一个 log 事务，
+// 总量不超过一个事务的容量时整个 writev 只有一次 begin_op/end_op。
+int
+filewritev(struct file *f, struct iovec *iov, int niov)
+{
+  int i, r, n1, off, total, intx;
+  int nb = logopblocks();
+  int max = ((nb-1-1-2) / 2) * BSIZE;
+
+  if(f->writable == 0)
+    return -1;
+
+  total = 0;
+  if(f->type == FD_PIPE){
+    for(i = 0; i < niov; i++){
+      r = pipewrite(f->pipe, (uint64)iov[i].iov_base, iov[i].iov_len);
+      if(r < 0)
+        return total > 0 ? total : -1;
+      total += r;
+      if(r < iov[i].iov_len)
+        break;
+    }
+  } else if(f->type == FD_DEVICE){
+    if(f->major < 0 || f->major >= NDEV || !devsw[f->major].write)
+      return -1;
+    for(i = 0; i < niov; i++){
+      r = devsw[f->major].write(1, (uint64)iov[i].iov_base, iov[i].iov_len);
+      if(r < 0)
+        return total > 0 ? total : -1;
+      total += r;
+      if(r < iov[i].iov_len)
+        break;
+    }
+  } else if(f->type == FD_INODE){
+    intx = 0;       // 当前事务里已经写了多少
+    for(i = 0; i < niov; i++){
+      for(off = 0; off < iov[i].iov_len; off += r){
+        n1 = iov[i].iov_len - off;
+        if(n1 > max)
+          n1 = max;
+        if(intx > 0 && intx + n1 > max){
+          iunlock(f->ip);
+          end_opn(nb);
+          intx = 0;
+        }
+        if(intx == 0){
+          begin_opn(nb);
+          ilock(f->ip);
+        }
+        if((r = writei(f->ip, 1, (uint64)iov[i].iov_base + off, f->off, n1)) > 0){
+          f->off += r;
+          total += r;
+          intx += r;
+        }
+        if(r != n1){
+          // error from writei
+          iunlock(f->ip);
+          end_opn(nb);
+          return total > 0 ? total : -1;
+        }
+      }
+    }
+    if(intx > 0){
+      iunlock(f->ip);
+      end_opn(nb);
+    }
+  } else if(f->type == FD_EVENT){
+    return -1;
+  } else {
+    panic("filewritev");
+  }
+  return total;
+}
+
+// labx poll
+// 返回 f 现在就绪的事件；e 非 0 时顺便把它挂到 f 的等待队列上，
+// 之后 f 的状态变化会叫醒 poll()。普通文件总是可读可写。
+int
+filepoll(struct file *f, int events, struct pollent *e)
+{
+  int r = 0;
+
+  if(f->type == FD_PIPE){
+    r = pipepoll(f->pipe, f->writable, e);
+  } else if(f->type == FD_DEVICE){
+    if(f->major < 0 || f->major >= NDEV)
+      return POLLNVAL;
+    if(devsw[f->major].poll)
+      r = devsw[f->major].poll(events, e);
+    else
+      r = POLLIN | POLLOUT;
+  } else if(f->type == FD_INODE){
+    r = POLLIN | POLLOUT;
+  } else if(f->type == FD_EVENT){
+    r = eventpoll(f, e);
+  }
+  if(!f->readable)
+    r &= ~POLLIN;
+  if(!f->writable)
+    r &= ~POLLOUT;
+  return r;
+}
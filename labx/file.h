@@ -0,0 +1,58 @@
+// labx poll
+// 可以被 poll 的对象 (pipe、终端、eventfd……) 各有一个，
+// 状态变化时调用 pollwakeup()。由 poll.c 里的 polllock 保护
+struct waitq {
+  struct pollent *head;
+};
+
+struct file {
+  enum { FD_NONE, FD_PIPE, FD_INODE, FD_DEVICE, FD_EVENT } type;
+  int ref; // reference count
+  char readable;
+  char writable;
+  struct pipe *pipe; // FD_PIPE
+  struct inode *ip;  // FD_INODE and FD_DEVICE
+  uint off;          // FD_INODE
+  short major;       // FD_DEVICE
+  uint64 count;      // FD_EVENT 计数器，由 eventfd.c 的 eventlock 保护
+  struct waitq pollq;  // FD_EVENT 等它的 poll()
+};
+
+#define major(dev)  ((dev) >> 16 & 0xFFFF)
+#define minor(dev)  ((dev) & 0xFFFF)
+#define	mkdev(m,n)  ((uint)((m)<<16| (n)))
+
+// in-memory copy of an inode
+struct inode {
+  uint dev;           // Device number
+  uint inum;          // Inode number
+  int ref;            // Reference count
+  struct sleeplock lock; // protects everything below here
+  int valid;          // inode has been read from disk?
+
+  short type;         // copy of disk inode
+  short major;
+  short minor;
+  short nlink;
+  uint size;
+  uint ver;           // labx 修改计数
+  uint addrs[NDIRECT+1];
+
+  // labx readahead: 顺序读检测，不在磁盘上
+  uint ranext;        // 上次 readi 结束后的下一个块
+  uint rawin;         // 预读窗口，0 表示不预读
+  uint raend;         // 已经预读到的块 (不含)
+};
+
+struct pollent;
+
+// map major device number to device functions.
+struct devsw {
+  int (*read)(int, uint64, int);
+  int (*write)(int, uint64, int);
+  int (*poll)(int, struct pollent*);  // labx 返回就绪的事件，并把 pollent 挂到设备的等待队列上
+};
+
+extern struct devsw devsw[];
+
+#define CONSOLE 1
@@ -0,0 +1,484 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/poll.h"
+#include "kernel/fcntl.h"
+#include "user/user.h"
+#include "kernel/fs.h"
+
+char *fmtname(char *path)
+{
+  static char buf[DIRSIZ+1];
+  char *p;
+
+  // Find first character after last slash.
+  for(p=path+strlen(path); p >= path && *p != '/'; p--)
+    ;
+  p++;
+
+  // Return blank-padded name.
+  if(strlen(p) >= DIRSIZ)
+    return p;
+  memmove(buf, p, strlen(p));
+  memset(buf+strlen(p), ' ', DIRSIZ-strlen(p));
+  return buf;
+}
+
+//printf("%s %d %d %l\n", fmtname(path), st.type, st.ino, st.size);
+
+// labx getdents: 一次取 NDENT 个目录项，类型就在目录项里，不用再 stat。
+// find 是递归的，用户栈只有一页，所以每层只放 8 个
+#define NDENT 8
+
+int find(char *path, char *filename)
+{
+    int cur_success = 0;
+    char buf[512], *p;
+    int fd, i, n;
+    struct xdirent de[NDENT];
+    struct stat st;
+
+    if((fd = open(path, 0)) < 0){
+        fprintf(2, "find: cannot open %s\n", path);
+        return 0;
+    }
+
+    if(fstat(fd, &st) < 0){
+        fprintf(2, "find: cannot stat %s\n", path);
+        close(fd);
+        return 0;
+    }
+
+    if(strlen(path) + 1 + DIRSIZ + 1 > sizeof buf){
+        printf("find: path too long\n");
+    }
+
+    // 如果当前目录是 dir_a，那么下面三句话后 p = "dir_a/"
+    strcpy(buf, path);
+    p = buf+strlen(buf);
+    *p++ = '/';
+
+    // 遍历当前目录
+    while((n = getdents(fd, de, NDENT)) > 0) {
+        for (i = 0; i < n; i++) {
+            // 不递归遍历本目录和上级目录
+            if (!strcmp(de[i].name, ".") || !strcmp(de[i].name, "..")) {
+                continue;
+            }
+
+            // 拼接当前路径
+            strcpy(p, de[i].name);
+
+            // 判断当前是目录还是文件
+            if (de[i].type == T_DIR) {
+                find(buf, filename);
+            } else if (de[i].type == T_FILE) {
+                if (!strcmp(de[i].name, filename)) {
+                    cur_success = 1;
+                    printf("%s\n", buf);
+                }
+            }
+        }
+    }
+
+    close(fd);
+    return cur_success;
+}
+
+// labx find -j
+// 协调者 (原来的进程) 手里有一个目录队列，fork 出 N 个 worker，
+// 每次通过命令 pipe 给空闲的 worker 发一个目录。worker 在自己的栈上深度优先
+// 遍历这个子树，结果经 printf 缓冲写到自己的结果 pipe：
+//   F<path>  找到的文件
+//   D<path>  交回给协调者的目录
+//   E        这个目录做完了，worker 空闲
+// 协调者用 poll 同时收所有结果 pipe，把找到的路径合并到 stdout。
+// 有 worker 空闲而队列是空的时候，协调者把空闲数写到共享页的 hungry 里；
+// 忙的 worker 每做完一个目录看一眼，能减到 hungry 就把栈底 (最浅的) 目录交回去。
+
+#define MAXJOBS  8
+#define STKMAX   256            // worker 栈上最多的目录数，再多就交回协调者
+#define RESULTSZ (4*4096)       // 结果 pipe 的缓冲区
+
+struct shared {
+    int hungry;                 // 还想要目录的空闲 worker 数
+};
+
+static struct shared *sh;
+
+// worker 待遍历的目录，lo 是栈底，hi 是栈顶
+static char *stk[STKMAX];
+static int lo, hi;
+
+static char *
+strdup(char *s)
+{
+    char *p;
+
+    if ((p = malloc(strlen(s) + 1)) == 0) {
+        fprintf(2, "find: out of memory\n");
+        exit(1);
+    }
+    strcpy(p, s);
+    return p;
+}
+
+// 抢一个 hungry，成功返回 1
+static int
+takehungry(void)
+{
+    int h;
+
+    while ((h = __atomic_load_n(&sh->hungry, __ATOMIC_RELAXED)) > 0) {
+        if (__sync_bool_compare_and_swap(&sh->hungry, h, h - 1))
+            return 1;
+    }
+    return 0;
+}
+
+static void
+push(char *path, int out)
+{
+    if (hi == STKMAX && lo > 0) {
+        memmove(stk, stk + lo, (hi - lo) * sizeof(stk[0]));
+        hi -= lo;
+        lo = 0;
+    }
+    if (hi == STKMAX) {
+        // 栈满了，直接交回协调者
+        fprintf(out, "D%s\n", path);
+        return;
+    }
+    stk[hi++] = strdup(path);
+}
+
+// 遍历 path 这一层：文件名匹配的输出，子目录压栈
+static void
+scandir(char *path, char *filename, int out)
+{
+    char buf[512], *p;
+    int fd, i, n;
+    struct xdirent de[NDENT];
+
+    if ((fd = open(path, 0)) < 0) {
+        fprintf(2, "find: cannot open %s\n", path);
+        return;
+    }
+    if (strlen(path) + 1 + DIRSIZ + 1 > sizeof buf) {
+        fprintf(2, "find: path too long\n");
+        close(fd);
+        return;
+    }
+
+    strcpy(buf, path);
+    p = buf+strlen(buf);
+    *p++ = '/';
+
+    while ((n = getdents(fd, de, NDENT)) > 0) {
+        for (i = 0; i < n; i++) {
+            if (!strcmp(de[i].name, ".") || !strcmp(de[i].name, ".."))
+                continue;
+            strcpy(p, de[i].name);
+            if (de[i].type == T_DIR) {
+                push(buf, out);
+            } else if (de[i].type == T_FILE && !strcmp(de[i].name, filename)) {
+                fprintf(out, "F%s\n", buf);
+            }
+        }
+    }
+    close(fd);
+}
+
+static void
+worker(int in, int out, char *filename)
+{
+    char *line, *path;
+    int n;
+
+    while ((n = getline(in, &line)) > 0) {
+        if (line[n - 1] == '\n')
+            line[n - 1] = 0;
+        lo = hi = 0;
+        push(line, out);
+        while (lo < hi) {
+            path = stk[--hi];
+            scandir(path, filename, out);
+            free(path);
+            // 至少给自己留一个目录
+            while (hi - lo >= 2 && takehungry()) {
+                fprintf(out, "D%s\n", stk[lo]);
+                free(stk[lo++]);
+                fflush(out);
+            }
+        }
+        fprintf(out, "E\n");
+        fflush(out);
+    }
+    exit(0);
+}
+
+// 协调者这边的 worker
+struct job {
+    int cmd;                    // 命令 pipe 的写端
+    int busy;
+    int n;                      // buf 里还没处理完的字节数
+    char buf[1024];
+};
+
+struct qent {
+    struct qent *next;
+    char path[];
+};
+
+static struct arena *qarena;
+static struct qent *qhead, **qtail = &qhead;
+
+static void
+enqueue(char *path)
+{
+    struct qent *e;
+
+    if ((e = arena_alloc(qarena, sizeof(*e) + strlen(path) + 1)) == 0) {
+        fprintf(2, "find: out of memory\n");
+        exit(1);
+    }
+    strcpy(e->path, path);
+    e->next = 0;
+    *qtail = e;
+    qtail = &e->next;
+}
+
+static char *
+dequeue(void)
+{
+    struct qent *e;
+
+    if ((e = qhead) == 0)
+        return 0;
+    if ((qhead = e->next) == 0)
+        qtail = &qhead;
+    return e->path;
+}
+
+int pfind(char *path, char *filename, int njobs)
+{
+    struct job jobs[MAXJOBS];
+    struct pollfd fds[MAXJOBS];
+    int cmd[2], res[2], i, n, nbusy, found;
+    char *p, *q, *dir;
+
+    if (njobs > MAXJOBS)
+        njobs = MAXJOBS;
+    if ((sh = chan_create()) == 0 || (qarena = arena_create()) == 0) {
+        fprintf(2, "find: out of memory\n");
+        exit(1);
+    }
+    sh->hungry = 0;
+
+    for (i = 0; i < njobs; i++) {
+        if (pipe(cmd) < 0 || pipe2(res, RESULTSZ) < 0) {
+            fprintf(2, "find: pipe failed\n");
+            exit(1);
+        }
+        if (fork() == 0) {
+            // 前面 worker 的命令 pipe 也要关掉，不然它们读不到 EOF
+            for (int j = 0; j < i; j++)
+                close(jobs[j].cmd);
+            close(cmd[1]);
+            close(res[0]);
+            worker(cmd[0], res[1], filename);
+        }
+        close(cmd[0]);
+        close(res[1]);
+        jobs[i].cmd = cmd[1];
+        jobs[i].busy = 0;
+        jobs[i].n = 0;
+        fds[i].fd = res[0];
+        fds[i].events = POLLIN;
+    }
+
+    enqueue(path);
+    nbusy = found = 0;
+    for (;;) {
+        for (i = 0; i < njobs && qhead; i++) {
+            if (jobs[i].busy)
+                continue;
+            dir = dequeue();
+            fprintf(jobs[i].cmd, "%s\n", dir);
+            fflush(jobs[i].cmd);
+            jobs[i].busy = 1;
+            nbusy++;
+        }
+        if (nbusy == 0)
+            break;
+        __atomic_store_n(&sh->hungry, qhead ? 0 : njobs - nbusy, __ATOMIC_RELAXED);
+
+        if (poll(fds, njobs, -1) < 0) {
+            fprintf(2, "find: poll failed\n");
+            exit(1);
+        }
+        for (i = 0; i < njobs; i++) {
+            if (fds[i].revents == 0)
+                continue;
+            struct job *j = &jobs[i];
+            if ((n = read(fds[i].fd, j->buf + j->n, sizeof(j->buf) - j->n - 1)) <= 0) {
+                fprintf(2, "find: worker %d died\n", i);
+                exit(1);
+            }
+            j->n += n;
+            j->buf[j->n] = 0;
+            for (p = j->buf; (q = strchr(p, '\n')) != 0; p = q + 1) {
+                *q = 0;
+                if (*p == 'F') {
+                    printf("%s\n", p + 1);
+                    found = 1;
+                } else if (*p == 'D') {
+                    enqueue(p + 1);
+                } else if (*p == 'E') {
+                    j->busy = 0;
+                    nbusy--;
+                }
+            }
+            j->n -= p - j->buf;
+            memmove(j->buf, p, j->n);
+        }
+    }
+
+    // 关掉命令 pipe，worker 读到 EOF 就退出
+    for (i = 0; i < njobs; i++) {
+        close(jobs[i].cmd);
+        close(fds[i].fd);
+    }
+    for (i = 0; i < njobs; i++)
+        wait(0);
+    arena_destroy(qarena);
+    return found;
+}
+
+// labx locate
+// find -l [dir] name 不遍历文件系统，而是在 updatedb 生成的 /locatedb 里找：
+// 整个索引读进内存，按文件名二分查找，每个命中的路径再 stat 一次确认还在。
+// 索引是上次 updatedb 时的样子，之后新建的文件找不到。dir 必须是绝对路径。
+
+static char *
+basename(char *path)
+{
+    char *p, *b;
+
+    for (p = b = path; *p; p++)
+        if (*p == '/')
+            b = p + 1;
+    return b;
+}
+
+int locate(char *dir, char *filename)
+{
+    struct stat st;
+    char *buf, **lines, *p, *q;
+    int fd, n, m, nline, lo, hi, mid, i, len, found;
+
+    if ((fd = open("/locatedb", O_RDONLY)) < 0) {
+        fprintf(2, "find: cannot open /locatedb, run updatedb first\n");
+        return 0;
+    }
+    if (fstat(fd, &st) < 0 || (buf = malloc(st.size + 1)) == 0) {
+        fprintf(2, "find: cannot read /locatedb\n");
+        close(fd);
+        return 0;
+    }
+    for (n = 0; n < st.size; n += m)
+        if ((m = read(fd, buf + n, st.size - n)) <= 0)
+            break;
+    close(fd);
+    buf[n] = 0;
+
+    // 一行一个路径，换行改成 0
+    nline = 0;
+    for (p = buf; *p; p++)
+        if (*p == '\n')
+            nline++;
+    if ((lines = malloc((nline + 1) * sizeof(char *))) == 0) {
+        fprintf(2, "find: out of memory\n");
+        free(buf);
+        return 0;
+    }
+    nline = 0;
+    for (p = buf; (q = strchr(p, '\n')) != 0; p = q + 1) {
+        *q = 0;
+        lines[nline++] = p;
+    }
+
+    // 第一个文件名 >= filename 的行
+    lo = 0;
+    hi = nline;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (strcmp(basename(lines[mid]), filename) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    found = 0;
+    len = dir ? strlen(dir) : 0;
+    if (len > 0 && dir[len - 1] == '/')
+        len--;
+    for (i = lo; i < nline && strcmp(basename(lines[i]), filename) == 0; i++) {
+        if (len > 0 && (memcmp(lines[i], dir, len) != 0 || lines[i][len] != '/'))
+            continue;
+        if (stat(lines[i], &st) < 0 || st.type != T_FILE)
+            continue;
+        printf("%s\n", lines[i]);
+        found = 1;
+    }
+    free(lines);
+    free(buf);
+    return found;
+}
+
+int main(int argc, char *argv[])
+{
+    // labx find -j N: 用 N 个 worker 进程并行查找
+    // labx find -l: 在 updatedb 的索引里查找
+    int njobs = 0, uselocate = 0;
+    for (;;) {
+        if (argc >= 3 && !strcmp(argv[1], "-j")) {
+            njobs = atoi(argv[2]);
+            argv += 2;
+            argc -= 2;
+        } else if (argc >= 2 && !strcmp(argv[1], "-l")) {
+            uselocate = 1;
+            argv++;
+            argc--;
+        } else {
+            break;
+        }
+    }
+
+    // 无参数，报错
+    if (argc == 1 || argc > 3) {
+        printf("ERROR: please follow the format find [-j N | -l] (DIR) <FILE>  ...\n");
+        exit(1);
+    }
+
+    // 一个参数，当前目录下寻找
+    int success = 0;
+    char *dir = argc == 2 ? "." : argv[1];
+    char *name = argc == 2 ? argv[1] : argv[2];
+    if (uselocate) {
+        if (argc == 3 && dir[0] != '/') {
+            printf("find: -l needs an absolute DIR\n");
+            exit(1);
+        }
+        success = locate(argc == 3 ? dir : 0, name);
+    } else if (njobs > 0) {
+        success = pfind(dir, name, njobs);
+    } else {
+        success = find(dir, name);
+    }
+
+    if (!success) {
+        printf("No such file...\n");
+    }
+
+    exit(0);
+}
@@ -0,0 +1,204 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+#include "kernel/spawn.h"
+#include "user/user.h"
+
+// labx printf: find 输出大量路径时，输出方式的开销
+//   逐字节：原来的 printf，每个字符一次 write
+//   逐次：setbuffered(fd, 0)，每次 printf 一次 write
+//   缓冲：现在默认的 printf，满 512 字节一次 write
+//   getdents：缓冲输出，再用 getdents 代替逐项 read + stat
+// 以及直接 spawn find (和 find -j 4) 把结果输出到文件。
+// 树是 fbtree/dI/dJ/x，一共 NDIR*NDIR 个 x。
+
+#define NDIR   8
+#define NROUND 10
+
+char *out = "fbtree.out";
+int mode;                 // 0 逐字节，1 逐次，2 缓冲，3 缓冲 + getdents
+int nfound;
+
+void
+emit(int fd, char *path)
+{
+  char *s;
+
+  if(mode == 0){
+    for(s = path; *s; s++)
+      write(fd, s, 1);
+    write(fd, "\n", 1);
+  } else {
+    fprintf(fd, "%s\n", path);
+  }
+}
+
+// 和 find 一样的遍历：目录递归，名字是 name 的文件输出路径
+void
+walk(int ofd, char *path, char *name)
+{
+  char buf[512], *p;
+  int fd, i, n;
+  struct dirent de;
+  struct xdirent xde[8];
+  struct stat st;
+
+  if((fd = open(path, 0)) < 0){
+    fprintf(2, "findbench: cannot open %s\n", path);
+    exit(1);
+  }
+  strcpy(buf, path);
+  p = buf+strlen(buf);
+  *p++ = '/';
+  while(mode == 3 && (n = getdents(fd, xde, 8)) > 0){
+    for(i = 0; i < n; i++){
+      if(!strcmp(xde[i].name, ".") || !strcmp(xde[i].name, ".."))
+        continue;
+      strcpy(p, xde[i].name);
+      if(xde[i].type == T_DIR){
+        walk(ofd, buf, name);
+      } else if(xde[i].type == T_FILE && !strcmp(xde[i].name, name)){
+        emit(ofd, buf);
+        nfound++;
+      }
+    }
+  }
+  while(mode != 3 && read(fd, &de, sizeof(de)) == sizeof(de)){
+    if(de.inum == 0 || !strcmp(de.name, ".") || !strcmp(de.name, ".."))
+      continue;
+    memmove(p, de.name, DIRSIZ);
+    p[DIRSIZ] = 0;
+    if(stat(buf, &st) < 0)
+      continue;
+    if(st.type == T_DIR){
+      walk(ofd, buf, name);
+    } else if(st.type == T_FILE && !strcmp(de.name, name)){
+      emit(ofd, buf);
+      nfound++;
+    }
+  }
+  close(fd);
+}
+
+void
+mktree(void)
+{
+  char path[32];
+  int i, j, fd;
+
+  if(mkdir("fbtree") < 0){
+    printf("findbench: mkdir fbtree failed (left over from last run?)\n");
+    exit(1);
+  }
+  for(i = 0; i < NDIR; i++){
+    strcpy(path, "fbtree/d?");
+    path[8] = '0' + i;
+    mkdir(path);
+    for(j = 0; j < NDIR; j++){
+      strcpy(path, "fbtree/d?/d?");
+      path[8] = '0' + i;
+      path[11] = '0' + j;
+      mkdir(path);
+      strcpy(path + 12, "/x");
+      if((fd = open(path, O_CREATE|O_WRONLY)) < 0){
+        printf("findbench: create %s failed\n", path);
+        exit(1);
+      }
+      close(fd);
+    }
+  }
+}
+
+void
+rmtree(void)
+{
+  char path[32];
+  int i, j;
+
+  for(i = 0; i < NDIR; i++){
+    for(j = 0; j < NDIR; j++){
+      strcpy(path, "fbtree/d?/d?/x");
+      path[8] = '0' + i;
+      path[11] = '0' + j;
+      unlink(path);
+      path[12] = 0;
+      unlink(path);
+    }
+    path[9] = 0;
+    unlink(path);
+  }
+  unlink("fbtree");
+  unlink(out);
+}
+
+int
+run(int m)
+{
+  int fd, r, t0;
+
+  mode = m;
+  t0 = uptime();
+  for(r = 0; r < NROUND; r++){
+    if((fd = open(out, O_CREATE|O_TRUNC|O_WRONLY)) < 0){
+      printf("findbench: open %s failed\n", out);
+      exit(1);
+    }
+    setbuffered(fd, mode >= 2);
+    nfound = 0;
+    walk(fd, "fbtree", "x");
+    close(fd);
+    if(nfound != NDIR*NDIR){
+      printf("findbench: found %d instead of %d\n", nfound, NDIR*NDIR);
+      exit(1);
+    }
+  }
+  return uptime() - t0;
+}
+
+int
+spawnfind(char **argv)
+{
+  struct spawn_action act[1];
+  int fd, r, t0, xstatus;
+
+  t0 = uptime();
+  for(r = 0; r < NROUND; r++){
+    if((fd = open(out, O_CREATE|O_TRUNC|O_WRONLY)) < 0){
+      printf("findbench: open %s failed\n", out);
+      exit(1);
+    }
+    act[0].op = SPAWN_DUP2;
+    act[0].fd = fd;
+    act[0].newfd = 1;
+    if(spawn("find", argv, act, 1) < 0){
+      printf("findbench: spawn find failed\n");
+      exit(1);
+    }
+    close(fd);
+    wait(&xstatus);
+    if(xstatus != 0){
+      printf("findbench: find failed\n");
+      exit(1);
+    }
+  }
+  return uptime() - t0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  char *find1[] = { "find", "fbtree", "x", 0 };
+  char *find4[] = { "find", "-j", "4", "fbtree", "x", 0 };
+
+  mktree();
+  printf("findbench: %d paths x %d rounds\n", NDIR*NDIR, NROUND);
+  printf("  per-byte write  %d ticks\n", run(0));
+  printf("  per-call write  %d ticks\n", run(1));
+  printf("  buffered        %d ticks\n", run(2));
+  printf("  getdents        %d ticks\n", run(3));
+  printf("  spawn find      %d ticks\n", spawnfind(find1));
+  printf("  spawn find -j 4 %d ticks\n", spawnfind(find4));
+  rmtree();
+  exit(0);
+}
@@ -0,0 +1,91 @@
+// On-disk file system format.
+// Both the kernel and user programs use this header file.
+
+
+#define ROOTINO  1   // root i-number
+#define BSIZE 1024  // block size
+
+// Disk layout:
+// [ boot block | super block | log | inode blocks |
+//                                          free bit map | data blocks]
+//
+// mkfs computes the super block and builds an initial file system. The
+// super block describes the disk layout:
+struct superblock {
+  uint magic;        // Must be FSMAGIC
+  uint size;         // Size of file system image (blocks)
+  uint nblocks;      // Number of data blocks
+  uint ninodes;      // Number of inodes.
+  uint nlog;         // Number of log blocks
+  uint logstart;     // Block number of first log block
+  uint inodestart;   // Block number of first inode block
+  uint bmapstart;    // Block number of first free map block
+};
+
+#define FSMAGIC 0x10203040
+
+// labx updatedb: 让出一个直接块给 dinode 的 ver
+#define NDIRECT 11
+#define NINDIRECT (BSIZE / sizeof(uint))
+#define MAXFILE (NDIRECT + NINDIRECT)
+
+// On-disk inode structure
+struct dinode {
+  short type;           // File type
+  short major;          // Major device number (T_DEVICE only)
+  short minor;          // Minor device number (T_DEVICE only)
+  short nlink;          // Number of links to inode in file system
+  uint size;            // Size of file (bytes)
+  uint ver;             // labx 修改计数：每次 writei 加一，inode 重新分配时接着加
+  uint addrs[NDIRECT+1];   // Data block addresses
+};
+
+// Inodes per block.
+#define IPB           (BSIZE / sizeof(struct dinode))
+
+// Block containing inode i
+#define IBLOCK(i, sb)     ((i) / IPB + sb.inodestart)
+
+// Bitmap bits per block
+#define BPB           (BSIZE*8)
+
+// Block of free map containing bit for block b
+#define BBLOCK(b, sb) ((b)/BPB + sb.bmapstart)
+
+// Directory is a file containing a sequence of dirent structures.
+#define DIRSIZ 14
+
+struct dirent {
+  ushort inum;
+  char name[DIRSIZ];
+};
+
+// labx hashed directory
+// minor 不为 0 的目录是散列目录，固定 minor 个块，每块是一个桶，见 fs.c。
+#define DPB           (BSIZE / sizeof(struct dirent))  // dirents per block
+#define DIRPROBE      4   // 一个名字最多放到往后第几个桶
+// 加目录项的系统调用 (create、link) 预留的日志块数：散列目录里一次插入最多给
+// DIRPROBE-1 个桶打标记，再写一个桶，桶可能是新分配的 (bitmap、间接块)，
+// 加上父目录 inode；create 还有子 inode 和散列子目录里 . 和 .. 的桶。
+#define DIROPBLOCKS   (MAXOPBLOCKS + DIRPROBE + 2)
+
+static inline uint
+dirhash(const char *name)
+{
+  uint h = 5381;
+  int i;
+
+  for(i = 0; i < DIRSIZ && name[i]; i++)
+    h = h * 33 + (uchar)name[i];
+  return h;
+}
+
+// labx getdents
+// getdents() 返回的目录项，带上 inode 的类型和大小，不用再 stat
+struct xdirent {
+  ushort inum;
+  short type;             // T_DIR, T_FILE, T_DEVICE
+  uint size;
+  char name[DIRSIZ+1];    // 以 0 结尾
+};
+
@@ -0,0 +1,130 @@
+// labx futex
+// 用户态同步用的 futex：futex_wait(addr, val) 在 *addr == val 时睡眠，
+// futex_wake(addr, n) 唤醒最多 n 个在 addr 上睡眠的线程。
+// 等待队列按 addr 对应的物理地址散列，这样共享同一个物理页的
+// 线程 (或进程) 用不同的虚拟地址也能互相唤醒。
+
+#include "types.h"
+#include "riscv.h"
+#include "param.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+
+#define NFUTEX 64             // 散列桶的个数
+
+// 一个等待者，放在 futex_wait() 的内核栈上
+struct futexwaiter {
+  uint64 pa;                  // 等待的物理地址
+  int woken;                  // futex_wake() 已经把它摘下来了
+  struct futexwaiter *next;
+};
+
+struct {
+  struct spinlock lock;
+  struct futexwaiter *head;
+} futextab[NFUTEX];
+
+void
+futexinit(void)
+{
+  for(int i = 0; i < NFUTEX; i++)
+    initlock(&futextab[i].lock, "futex");
+}
+
+// 把用户地址翻译成物理地址，要求 4 字节对齐
+static uint64
+futexaddr(uint64 va)
+{
+  uint64 pa;
+
+  if(va % sizeof(int) != 0 || va >= myproc()->sz)
+    return 0;
+  if((pa = walkaddr(myproc()->pagetable, va)) == 0)
+    return 0;
+  return pa + (va & (PGSIZE-1));
+}
+
+static int
+futexhash(uint64 pa)
+{
+  return (pa / sizeof(int)) % NFUTEX;
+}
+
+// *addr 仍然等于 val 就睡眠，被 futex_wake() 唤醒返回 0；
+// 值已经变了或者被 kill 返回 -1。
+// 比较在桶锁里做，唤醒者改完值再拿桶锁，所以不会丢失唤醒。
+int
+futex_wait(uint64 addr, int val)
+{
+  struct futexwaiter w, **pp;
+  struct vmspace *vm;
+  uint64 pa;
+  int h;
+
+  // labx clone: 比较时 pa 这一页不能被别的线程 sbrk 缩小回收掉
+  vm = vmaccess_begin();
+  if((pa = futexaddr(addr)) == 0){
+    vmaccess_end(vm);
+    return -1;
+  }
+  h = futexhash(pa);
+
+  acquire(&futextab[h].lock);
+  if(*(volatile int*)pa != val){
+    release(&futextab[h].lock);
+    vmaccess_end(vm);
+    return -1;
+  }
+  vmaccess_end(vm);
+  w.pa = pa;
+  w.woken = 0;
+  w.next = 0;
+  // 排到队尾，先来的先被唤醒
+  for(pp = &futextab[h].head; *pp; pp = &(*pp)->next)
+    ;
+  *pp = &w;
+
+  while(!w.woken && !myproc()->killed)
+    sleep(&w, &futextab[h].lock);
+
+  if(!w.woken){
+    // 被 kill 了，自己从队列里摘下来
+    for(pp = &futextab[h].head; *pp; pp = &(*pp)->next){
+      if(*pp == &w){
+        *pp = w.next;
+        break;
+      }
+    }
+  }
+  release(&futextab[h].lock);
+  return w.woken ? 0 : -1;
+}
+
+// 唤醒最多 n 个等待 addr 的线程，返回唤醒的个数
+int
+futex_wake(uint64 addr, int n)
+{
+  struct futexwaiter *w, **pp;
+  uint64 pa;
+  int h, woken = 0;
+
+  if((pa = futexaddr(addr)) == 0)
+    return -1;
+  h = futexhash(pa);
+
+  acquire(&futextab[h].lock);
+  pp = &futextab[h].head;
+  while((w = *pp) != 0 && woken < n){
+    if(w->pa == pa){
+      *pp = w->next;
+      w->woken = 1;
+      wakeup(w);
+      woken++;
+    } else {
+      pp = &w->next;
+    }
+  }
+  release(&futextab[h].lock);
+  return woken;
+}
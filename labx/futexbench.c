@@ -0,0 +1,92 @@
+#include "kernel/types.h"
+#include "user/user.h"
+
+// labx futex: 比较两种在线程之间来回交接的开销
+//   futex: mutex + cond，轮到谁谁干活
+//   pipe:  用两根 pipe 当信号量，read 是 P，write 是 V
+// 以及没有竞争时 mutex_lock/mutex_unlock 的开销
+
+#define N 10000
+
+struct mutex m;
+struct cond c;
+volatile int turn;
+int p0[2], p1[2];
+
+// 等 turn == me，再交给另一个线程
+void
+futexside(int me)
+{
+  for(int i = 0; i < N; i++){
+    mutex_lock(&m);
+    while(turn != me)
+      cond_wait(&c, &m);
+    turn = !me;
+    cond_signal(&c);
+    mutex_unlock(&m);
+  }
+}
+
+void
+futexpeer(void *arg)
+{
+  futexside(1);
+}
+
+void
+pipepeer(void *arg)
+{
+  char b;
+
+  for(int i = 0; i < N; i++){
+    if(read(p1[0], &b, 1) != 1 || write(p0[1], &b, 1) != 1)
+      exit(1);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, t0, t1;
+  char b = 0;
+
+  t0 = uptime();
+  for(i = 0; i < N*100; i++){
+    mutex_lock(&m);
+    mutex_unlock(&m);
+  }
+  t1 = uptime();
+  printf("futexbench: %d uncontended lock/unlock: %d ticks\n", N*100, t1 - t0);
+
+  turn = 0;
+  t0 = uptime();
+  if(thread_create(futexpeer, 0) < 0){
+    printf("futexbench: thread_create failed\n");
+    exit(1);
+  }
+  futexside(0);
+  thread_join();
+  t1 = uptime();
+  printf("futexbench: %d futex handoffs: %d ticks\n", 2*N, t1 - t0);
+
+  if(pipe(p0) < 0 || pipe(p1) < 0){
+    printf("futexbench: pipe failed\n");
+    exit(1);
+  }
+  t0 = uptime();
+  if(thread_create(pipepeer, 0) < 0){
+    printf("futexbench: thread_create failed\n");
+    exit(1);
+  }
+  for(i = 0; i < N; i++){
+    if(write(p1[1], &b, 1) != 1 || read(p0[0], &b, 1) != 1){
+      printf("futexbench: pipe handoff failed\n");
+      exit(1);
+    }
+  }
+  thread_join();
+  t1 = uptime();
+  printf("futexbench: %d pipe handoffs: %d ticks\n", 2*N, t1 - t0);
+
+  exit(0);
+}
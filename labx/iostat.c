@@ -0,0 +1,67 @@
+#include "kernel/types.h"
+#include "kernel/iostat.h"
+#include "kernel/dcache.h"
+#include "user/user.h"
+
+// labx iostat
+// iostat：打印开机以来的磁盘请求计数
+// iostat cmd [args...]：运行 cmd，打印它运行期间的增量
+// 块数是提交给驱动的请求数 (不合并时就是发给设备的请求数)，
+// 请求数是合并以后实际发给设备的。
+// labx dcache: 接着打印名字缓存的命中情况，比如 iostat find . x
+
+void
+report(struct iostat *a, struct iostat *b)
+{
+  printf("  read   %l blocks in %l requests\n", b->rblocks - a->rblocks, b->rreq - a->rreq);
+  printf("  write  %l blocks in %l requests\n", b->wblocks - a->wblocks, b->wreq - a->wreq);
+  printf("  notify %l\n", b->kicks - a->kicks);
+}
+
+void
+dcreport(struct dcstat *a, struct dcstat *b)
+{
+  uint64 hits, neg, miss, all;
+
+  hits = b->hits - a->hits;
+  neg = b->neghits - a->neghits;
+  miss = b->misses - a->misses;
+  all = hits + neg + miss;
+  printf("  lookups %l: hit %l, negative hit %l, miss %l\n", all, hits, neg, miss);
+  if(all)
+    printf("  hit rate %l.%l%%\n", (hits + neg) * 100 / all, (hits + neg) * 1000 / all % 10);
+  printf("  evicted %l\n", b->evicts - a->evicts);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct iostat zero, before, after;
+  struct dcstat dzero, dbefore, dafter;
+  int xstatus;
+
+  if(argc < 2){
+    memset(&zero, 0, sizeof(zero));
+    memset(&dzero, 0, sizeof(dzero));
+    iostat(&after);
+    dcstat(&dafter);
+    printf("iostat: since boot\n");
+    report(&zero, &after);
+    dcreport(&dzero, &dafter);
+    exit(0);
+  }
+
+  iostat(&before);
+  dcstat(&dbefore);
+  if(spawn(argv[1], argv+1, 0, 0) < 0){
+    fprintf(2, "iostat: cannot run %s\n", argv[1]);
+    exit(1);
+  }
+  wait(&xstatus);
+  iostat(&after);
+  dcstat(&dafter);
+  printf("iostat: %s exited with %d\n", argv[1], xstatus);
+  report(&before, &after);
+  dcreport(&dbefore, &dafter);
+  exit(0);
+}
@@ -0,0 +1,9 @@
+// labx iostat
+// 磁盘请求的计数，从开机开始累计
+struct iostat {
+  uint64 rblocks;   // 提交给磁盘驱动的读块数
+  uint64 wblocks;   // 写块数
+  uint64 rreq;      // 合并后实际发给设备的读请求数
+  uint64 wreq;      // 写请求数
+  uint64 kicks;     // 通知设备的次数
+};
@@ -0,0 +1,106 @@
+#include "kernel/types.h"
+#include "kernel/fcntl.h"
+#include "kernel/uio.h"
+#include "user/user.h"
+
+// labx readv/writev: 文件、pipe 和终端上的 readv/writev
+
+char hdr[8] = "header: ";
+char body[5000];
+char buf[sizeof(hdr) + sizeof(body)];
+
+void
+fill(struct iovec *iov, char *a, int na, char *b, int nb)
+{
+  iov[0].iov_base = a;
+  iov[0].iov_len = na;
+  iov[1].iov_base = b;
+  iov[1].iov_len = nb;
+}
+
+void
+testfile()
+{
+  struct iovec iov[2];
+  char h[sizeof(hdr)];
+  int fd, n;
+
+  fd = open("iov.tmp", O_CREATE|O_RDWR|O_TRUNC);
+  fill(iov, hdr, sizeof(hdr), body, sizeof(body));
+  if((n = writev(fd, iov, 2)) != sizeof(buf)){
+    printf("iovtest: FAIL file writev returned %d\n", n);
+    exit(1);
+  }
+  close(fd);
+
+  fd = open("iov.tmp", O_RDONLY);
+  fill(iov, h, sizeof(h), buf, sizeof(body));
+  if((n = readv(fd, iov, 2)) != sizeof(buf)){
+    printf("iovtest: FAIL file readv returned %d\n", n);
+    exit(1);
+  }
+  if(memcmp(h, hdr, sizeof(hdr)) != 0 || memcmp(buf, body, sizeof(body)) != 0){
+    printf("iovtest: FAIL file contents\n");
+    exit(1);
+  }
+  close(fd);
+  unlink("iov.tmp");
+}
+
+void
+testpipe()
+{
+  struct iovec iov[2];
+  int fds[2], n;
+
+  pipe2(fds, 8192);
+  fill(iov, hdr, sizeof(hdr), body, 100);
+  if(writev(fds[1], iov, 2) != sizeof(hdr) + 100){
+    printf("iovtest: FAIL pipe writev\n");
+    exit(1);
+  }
+  // 第二段比 pipe 里剩下的多，只拿到已有的
+  fill(iov, buf, 4, buf + 4, sizeof(buf) - 4);
+  if((n = readv(fds[0], iov, 2)) != sizeof(hdr) + 100){
+    printf("iovtest: FAIL pipe readv returned %d\n", n);
+    exit(1);
+  }
+  if(memcmp(buf, hdr, sizeof(hdr)) != 0 || memcmp(buf + sizeof(hdr), body, 100) != 0){
+    printf("iovtest: FAIL pipe contents\n");
+    exit(1);
+  }
+  close(fds[0]);
+  close(fds[1]);
+}
+
+void
+testconsole()
+{
+  struct iovec iov[3];
+
+  iov[0].iov_base = "iovtest: ";
+  iov[0].iov_len = 9;
+  iov[1].iov_base = "console ";
+  iov[1].iov_len = 8;
+  iov[2].iov_base = "writev\n";
+  iov[2].iov_len = 7;
+  if(writev(1, iov, 3) != 24){
+    printf("iovtest: FAIL console writev\n");
+    exit(1);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i;
+
+  for(i = 0; i < sizeof(body); i++)
+    body[i] = 'a' + i % 26;
+  printf("iovtest: start\n");
+  testfile();
+  testpipe();
+  testconsole();
+  printf("iovtest: OK\n");
+  exit(0);
+}
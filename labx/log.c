@@ -0,0 +1,320 @@
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+
+// Simple logging that allows concurrent FS system calls.
+//
+// A log transaction contains the updates of multiple FS system
+// calls. The logging system only commits when there are
+// no FS system calls active. Thus there is never
+// any reasoning required about whether a commit might
+// write an uncommitted system call's updates to disk.
+//
+// A system call should call begin_op()/end_op() to mark
+// its start and end. Usually begin_op() just increments
+// the count of in-progress FS system calls and returns.
+// But if it thinks the log is close to running out, it
+// sleeps until the last outstanding end_op() commits.
+//
+// The log is a physical re-do log containing disk blocks.
+// The on-disk log format:
+//   header block, containing block #s for block A, B, C, ...
+//   block A
+//   block B
+//   block C
+//   ...
+// Log appends are synchronous.
+//
+// labx group commit
+// 内存里有两个事务 txn[0]、txn[1]。提交 txn[cur] 时先把 cur 换到另一个，
+// 新的系统调用不用等这次提交，直接加入另一个事务；提交期间结束的事务
+// 由正在提交的进程接着提交，这样多个进程的操作攒成一次提交。
+// 提交开始时把事务里的块拍一份快照到 shadow[]，只有拍快照时 begin_op 要等，
+// 之后写日志和装回原位置都用快照，新事务改缓存里的块不会混进来。
+// 提交是串行的，上一次提交装回并清掉 header 之后才开始下一次，
+// 所以磁盘上仍然只有一个日志区。日志大小由 mkfs -l 决定，最多 LOGMAX 块。
+
+// Contents of the header block, used for both the on-disk header block
+// and to keep track in memory of logged block# before commit.
+struct logheader {
+  int n;
+  int block[LOGMAX];
+};
+
+// labx: 内存里的一个事务
+struct logtxn {
+  struct logheader lh;
+  struct buf *buf[LOGMAX]; // lh.block[i] 在缓存里的 buf，log_write() 时 bpin
+  int outstanding;         // how many FS sys calls are executing.
+  int reserved;            // 它们预留的块数
+};
+
+struct log {
+  struct spinlock lock;
+  int start;
+  int size;
+  int committing;  // in commit(), 提交完会接着提交 txn[cur]
+  int copying;     // commit() 在拍快照，begin_op 要等
+  int dev;
+  int cur;         // 新的系统调用加入 txn[cur]
+  struct logtxn txn[2];
+};
+struct log log;
+
+// labx: 提交时的快照，不在 buffer cache 里，只用来发磁盘请求
+static struct buf shadow[LOGMAX];
+
+static void recover_from_log(void);
+static void commit(struct logtxn*);
+
+void
+initlog(int dev, struct superblock *sb)
+{
+  if (sizeof(struct logheader) >= BSIZE)
+    panic("initlog: too big logheader");
+  if (sb->nlog > LOGMAX)
+    panic("initlog: log bigger than LOGMAX");
+
+  initlock(&log.lock, "log");
+  for (int i = 0; i < LOGMAX; i++)
+    initsleeplock(&shadow[i].lock, "logshadow");
+  log.start = sb->logstart;
+  log.size = sb->nlog;
+  log.dev = dev;
+  recover_from_log();
+}
+
+// Read the log header from disk into lh
+static void
+read_head(struct logheader *lh)
+{
+  struct buf *buf = bread(log.dev, log.start);
+  struct logheader *hb = (struct logheader *) (buf->data);
+  int i;
+  lh->n = hb->n;
+  for (i = 0; i < lh->n; i++) {
+    lh->block[i] = hb->block[i];
+  }
+  brelse(buf);
+}
+
+// Write in-memory log header to disk.
+// This is the true point at which the
+// current transaction commits.
+static void
+write_head(struct logheader *lh)
+{
+  struct buf *buf = bread(log.dev, log.start);
+  struct logheader *hb = (struct logheader *) (buf->data);
+  int i;
+  hb->n = lh->n;
+  for (i = 0; i < lh->n; i++) {
+    hb->block[i] = lh->block[i];
+  }
+  bwrite(buf);
+  brelse(buf);
+}
+
+// Copy committed blocks from log to their home location.
+// 只在启动时用，这时没有别的系统调用，直接经过缓存。
+static void
+recover_from_log(void)
+{
+  struct logheader lh;
+  struct buf *dbuf[8];
+  int tail, i, n;
+
+  read_head(&lh);
+  for (tail = 0; tail < lh.n; tail += n) {
+    n = lh.n - tail;
+    if(n > NELEM(dbuf))
+      n = NELEM(dbuf);
+    for (i = 0; i < n; i++)
+      breadahead(log.dev, log.start+tail+i+1);
+    bkick();
+    for (i = 0; i < n; i++) {
+      struct buf *lbuf = bread(log.dev, log.start+tail+i+1); // read log block
+      dbuf[i] = bread(log.dev, lh.block[tail+i]); // read dst
+      memmove(dbuf[i]->data, lbuf->data, BSIZE);  // copy block to dst
+      bwrite_async(dbuf[i]);  // write dst to disk
+      brelse(lbuf);
+    }
+    for (i = 0; i < n; i++) {
+      bwait(dbuf[i]);
+      brelse(dbuf[i]);
+    }
+  }
+  lh.n = 0;
+  write_head(&lh); // clear the log
+}
+
+// called at the start of each FS system call.
+// labx: n 是这个系统调用最多会写的块数。
+void
+begin_opn(int n)
+{
+  struct logtxn *t;
+
+  acquire(&log.lock);
+  while(1){
+    t = &log.txn[log.cur];
+    if(log.copying){
+      sleep(&log, &log.lock);
+    } else if(t->lh.n + t->reserved + n > log.size){
+      // this op might exhaust log space; wait for commit.
+      sleep(&log, &log.lock);
+    } else {
+      t->outstanding += 1;
+      t->reserved += n;
+      release(&log.lock);
+      break;
+    }
+  }
+}
+
+void
+begin_op(void)
+{
+  begin_opn(MAXOPBLOCKS);
+}
+
+// called at the end of each FS system call.
+// commits if this was the last outstanding operation.
+// labx: n 和 begin_opn() 的一样。提交期间结束的事务不在这里提交，
+// 正在提交的进程做完手上的会接着提交它。
+void
+end_opn(int n)
+{
+  struct logtxn *t;
+
+  acquire(&log.lock);
+  t = &log.txn[log.cur];
+  t->outstanding -= 1;
+  t->reserved -= n;
+  if(t->outstanding == 0 && !log.committing){
+    log.committing = 1;
+    while((t = &log.txn[log.cur])->outstanding == 0 && t->lh.n > 0){
+      // 另一个事务上次已经提交完了，新的系统调用从现在起加入它
+      log.cur ^= 1;
+      log.copying = 1;
+      // call commit w/o holding locks, since not allowed
+      // to sleep with locks.
+      release(&log.lock);
+      commit(t);
+      acquire(&log.lock);
+    }
+    log.committing = 0;
+  }
+  // begin_op() may be waiting for log space,
+  // and decrementing outstanding has decreased
+  // the amount of reserved space.
+  wakeup(&log);
+  release(&log.lock);
+}
+
+void
+end_op(void)
+{
+  end_opn(MAXOPBLOCKS);
+}
+
+// labx: 写文件时一个事务预留的块数，日志的一半，至少 MAXOPBLOCKS
+int
+logopblocks(void)
+{
+  int n = log.size / 2;
+  return n < MAXOPBLOCKS ? MAXOPBLOCKS : n;
+}
+
+// labx: 把 t 里的块拍快照到 shadow[]，然后放行新的系统调用。
+// t 的系统调用都结束了，新的还没开始，缓存里就是 t 提交时的内容。
+static void
+snapshot(struct logtxn *t)
+{
+  int i;
+
+  for (i = 0; i < t->lh.n; i++) {
+    struct buf *b = bread(log.dev, t->lh.block[i]); // pinned, no disk read
+    acquiresleep(&shadow[i].lock);
+    shadow[i].dev = log.dev;
+    memmove(shadow[i].data, b->data, BSIZE);
+    brelse(b);
+  }
+
+  acquire(&log.lock);
+  log.copying = 0;
+  wakeup(&log);
+  release(&log.lock);
+}
+
+// labx: 把 shadow[0..n-1] 写到 blockno[i]，一起提交，一起等。
+// 写日志时块号连续，电梯会合并成几个大请求。
+static void
+write_shadow(int n, int *blockno)
+{
+  int i;
+
+  for (i = 0; i < n; i++) {
+    shadow[i].blockno = blockno ? blockno[i] : log.start+i+1;
+    bwrite_async(&shadow[i]);
+  }
+  for (i = 0; i < n; i++)
+    bwait(&shadow[i]);
+}
+
+static void
+commit(struct logtxn *t)
+{
+  int i, n = t->lh.n;
+
+  snapshot(t);
+  write_shadow(n, 0);            // Write modified blocks to log
+  write_head(&t->lh);            // Write header to disk -- the real commit
+  write_shadow(n, t->lh.block);  // Now install writes to home locations
+  for (i = 0; i < n; i++) {
+    releasesleep(&shadow[i].lock);
+    bunpin(t->buf[i]);
+  }
+  t->lh.n = 0;
+  write_head(&t->lh);            // Erase the transaction from the log
+}
+
+// Caller has modified b->data and is done with the buffer.
+// Record the block number and pin in the cache by increasing refcnt.
+// commit() will do the disk write.
+//
+// log_write() replaces bwrite(); a typical use is:
+//   bp = bread(...)
+//   modify bp->data[]
+//   log_write(bp)
+//   brelse(bp)
+void
+log_write(struct buf *b)
+{
+  struct logtxn *t;
+  int i;
+
+  acquire(&log.lock);
+  t = &log.txn[log.cur];
+  if (t->lh.n >= log.size - 1)
+    panic("too big a transaction");
+  if (t->outstanding < 1)
+    panic("log_write outside of trans");
+
+  for (i = 0; i < t->lh.n; i++) {
+    if (t->lh.block[i] == b->blockno)   // log absorption
+      break;
+  }
+  t->lh.block[i] = b->blockno;
+  if (i == t->lh.n) {  // Add new block to log?
+    bpin(b);
+    t->buf[i] = b;
+    t->lh.n++;
+  }
+  release(&log.lock);
+}
@@ -0,0 +1,224 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+// labx malloc: 新 malloc 和原来的 K&R 分配器的对比
+//   混合：NSLOT 个槽随机替换，大小 80% 8~128、15% 128~2000、5% 4K~16K
+//   小块：连续分配 NSMALL 个 16~64 字节的块再全部释放，以及用 arena 做同样的事
+// K&R 分配器原样复制在下面，改名为 krmalloc/krfree。
+
+#define NSLOT  256
+#define NMIXED 20000
+#define NSMALL 5000
+#define NROUND 10
+
+void *slot[NSLOT];
+void *small[NSMALL];
+uint seed = 1;
+
+uint
+rnd(void)
+{
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 16) & 0x7fff;
+}
+
+uint
+mixedsize(void)
+{
+  uint r = rnd() % 100;
+
+  if(r < 80)
+    return 8 + rnd() % 120;
+  if(r < 95)
+    return 128 + rnd() % 1872;
+  return 4096 + rnd() % 12288;
+}
+
+// K&R 分配器 (原来的 umalloc.c)
+
+typedef long Align;
+
+union header {
+  struct {
+    union header *ptr;
+    uint size;
+  } s;
+  Align x;
+};
+
+typedef union header Header;
+
+static Header base;
+static Header *freep;
+
+void
+krfree(void *ap)
+{
+  Header *bp, *p;
+
+  bp = (Header*)ap - 1;
+  for(p = freep; !(bp > p && bp < p->s.ptr); p = p->s.ptr)
+    if(p >= p->s.ptr && (bp > p || bp < p->s.ptr))
+      break;
+  if(bp + bp->s.size == p->s.ptr){
+    bp->s.size += p->s.ptr->s.size;
+    bp->s.ptr = p->s.ptr->s.ptr;
+  } else
+    bp->s.ptr = p->s.ptr;
+  if(p + p->s.size == bp){
+    p->s.size += bp->s.size;
+    p->s.ptr = bp->s.ptr;
+  } else
+    p->s.ptr = bp;
+  freep = p;
+}
+
+static Header*
+krmorecore(uint nu)
+{
+  char *p;
+  Header *hp;
+
+  if(nu < 4096)
+    nu = 4096;
+  p = sbrk(nu * sizeof(Header));
+  if(p == (char*)-1)
+    return 0;
+  hp = (Header*)p;
+  hp->s.size = nu;
+  krfree((void*)(hp + 1));
+  return freep;
+}
+
+void*
+krmalloc(uint nbytes)
+{
+  Header *p, *prevp;
+  uint nunits;
+
+  nunits = (nbytes + sizeof(Header) - 1)/sizeof(Header) + 1;
+  if((prevp = freep) == 0){
+    base.s.ptr = freep = prevp = &base;
+    base.s.size = 0;
+  }
+  for(p = prevp->s.ptr; ; prevp = p, p = p->s.ptr){
+    if(p->s.size >= nunits){
+      if(p->s.size == nunits)
+        prevp->s.ptr = p->s.ptr;
+      else {
+        p->s.size -= nunits;
+        p += p->s.size;
+        p->s.size = nunits;
+      }
+      freep = prevp;
+      return (void*)(p + 1);
+    }
+    if(p == freep)
+      if((p = krmorecore(nunits)) == 0)
+        return 0;
+  }
+}
+
+struct allocator {
+  char *name;
+  void *(*alloc)(uint);
+  void (*free)(void *);
+};
+
+struct allocator allocators[] = {
+  { "K&R",    krmalloc, krfree },
+  { "sized",  malloc,   free },
+};
+
+int
+mixed(struct allocator *a)
+{
+  int i, j, t0;
+  uint n;
+
+  seed = 1;
+  t0 = uptime();
+  for(i = 0; i < NMIXED; i++){
+    j = rnd() % NSLOT;
+    if(slot[j])
+      a->free(slot[j]);
+    n = mixedsize();
+    if((slot[j] = a->alloc(n)) == 0){
+      printf("mallocbench: %s: out of memory\n", a->name);
+      exit(1);
+    }
+    memset(slot[j], i, n < 64 ? n : 64);
+  }
+  for(j = 0; j < NSLOT; j++){
+    if(slot[j])
+      a->free(slot[j]);
+    slot[j] = 0;
+  }
+  return uptime() - t0;
+}
+
+int
+smallall(struct allocator *a)
+{
+  int i, r, t0;
+
+  seed = 1;
+  t0 = uptime();
+  for(r = 0; r < NROUND; r++){
+    for(i = 0; i < NSMALL; i++){
+      if((small[i] = a->alloc(16 + rnd() % 48)) == 0){
+        printf("mallocbench: %s: out of memory\n", a->name);
+        exit(1);
+      }
+      *(char*)small[i] = i;
+    }
+    for(i = 0; i < NSMALL; i++)
+      a->free(small[i]);
+  }
+  return uptime() - t0;
+}
+
+int
+smallarena(void)
+{
+  struct arena *a;
+  int i, r, t0;
+  char *p;
+
+  seed = 1;
+  t0 = uptime();
+  for(r = 0; r < NROUND; r++){
+    if((a = arena_create()) == 0){
+      printf("mallocbench: arena_create failed\n");
+      exit(1);
+    }
+    for(i = 0; i < NSMALL; i++){
+      if((p = arena_alloc(a, 16 + rnd() % 48)) == 0){
+        printf("mallocbench: arena: out of memory\n");
+        exit(1);
+      }
+      *p = i;
+    }
+    arena_destroy(a);
+  }
+  return uptime() - t0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct allocator *a;
+  char *brk;
+
+  printf("mallocbench: %d mixed ops, %d rounds of %d small blocks\n",
+         NMIXED, NROUND, NSMALL);
+  for(a = allocators; a < allocators + sizeof(allocators)/sizeof(allocators[0]); a++){
+    brk = sbrk(0);
+    printf("  %s: mixed %d ticks", a->name, mixed(a));
+    printf(", small %d ticks", smallall(a));
+    printf(", heap +%d KB\n", (int)(sbrk(0) - brk) / 1024);
+  }
+  printf("  arena: small %d ticks\n", smallarena());
+  exit(0);
+}
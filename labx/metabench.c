@@ -0,0 +1,107 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/iostat.h"
+#include "user/user.h"
+
+// labx group commit: 元数据密集的负载
+// nproc 个进程各自在自己的目录 mbI 里反复创建、写一个字节、删除文件，
+// 每个进程 nfile 个文件、nround 轮。每次 create 和 unlink 都是一个事务，
+// 报告每秒的操作数和平均每个操作写了几个块、几个磁盘请求：
+// 进程越多，一次提交里攒的操作越多，每个操作分到的写就越少。
+
+#define NROUND  4
+// 同时存在的文件总数上限：mkfs 只建 NINODES=200 个 inode，fs.img 自己用掉 80 个左右
+#define MAXLIVE 100
+
+void
+worker(int id, int nfile)
+{
+  char path[16];
+  int i, r, fd;
+
+  strcpy(path, "mb?/f??");
+  path[2] = '0' + id;
+  for(r = 0; r < NROUND; r++){
+    for(i = 0; i < nfile; i++){
+      path[5] = '0' + i / 10;
+      path[6] = '0' + i % 10;
+      if((fd = open(path, O_CREATE|O_WRONLY)) < 0){
+        printf("metabench: create %s failed\n", path);
+        exit(1);
+      }
+      write(fd, "x", 1);
+      close(fd);
+    }
+    for(i = 0; i < nfile; i++){
+      path[5] = '0' + i / 10;
+      path[6] = '0' + i % 10;
+      if(unlink(path) < 0){
+        printf("metabench: unlink %s failed\n", path);
+        exit(1);
+      }
+    }
+  }
+  exit(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct iostat before, after;
+  char dir[4];
+  int nproc, nfile, i, xstatus, fail;
+  uint64 t, nop;
+
+  nproc = argc > 1 ? atoi(argv[1]) : 4;
+  nfile = argc > 2 ? atoi(argv[2]) : 20;
+  if(argc > 3 || nproc < 1 || nproc > 10 || nfile < 1 || nfile > 100){
+    fprintf(2, "usage: metabench [nproc(1-10) [nfile(1-100)]]\n");
+    exit(1);
+  }
+  if(nproc * nfile > MAXLIVE){
+    fprintf(2, "metabench: nproc * nfile must be at most %d (not enough inodes)\n", MAXLIVE);
+    exit(1);
+  }
+
+  strcpy(dir, "mb?");
+  for(i = 0; i < nproc; i++){
+    dir[2] = '0' + i;
+    if(mkdir(dir) < 0){
+      printf("metabench: mkdir %s failed (left over from last run?)\n", dir);
+      exit(1);
+    }
+  }
+
+  iostat(&before);
+  t = rdtime();
+  for(i = 0; i < nproc; i++){
+    if(fork() == 0)
+      worker(i, nfile);
+  }
+  fail = 0;
+  for(i = 0; i < nproc; i++){
+    wait(&xstatus);
+    if(xstatus != 0)
+      fail = 1;
+  }
+  t = rdtime() - t;
+  iostat(&after);
+
+  for(i = 0; i < nproc; i++){
+    dir[2] = '0' + i;
+    unlink(dir);
+  }
+  if(fail){
+    printf("metabench: worker failed\n");
+    exit(1);
+  }
+
+  nop = (uint64)nproc * nfile * NROUND * 2;
+  printf("metabench: %d procs, %l creates + unlinks in %l us\n", nproc, nop, t * 1000000 / TIMEHZ);
+  printf("  %l ops/sec\n", nop * TIMEHZ / (t + 1));
+  printf("  %l.%l blocks written per op, %l.%l write requests per op\n",
+         (after.wblocks - before.wblocks) / nop, (after.wblocks - before.wblocks) * 10 / nop % 10,
+         (after.wreq - before.wreq) / nop, (after.wreq - before.wreq) * 10 / nop % 10);
+  exit(0);
+}
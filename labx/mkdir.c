@@ -0,0 +1,35 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+int
+main(int argc, char *argv[])
+{
+  int i, nbucket;
+
+  // labx hashed directory: mkdir -h nbucket dir... 建散列目录
+  nbucket = 0;
+  i = 1;
+  if(argc > 2 && strcmp(argv[1], "-h") == 0){
+    nbucket = atoi(argv[2]);
+    if(nbucket < 1){
+      fprintf(2, "mkdir: bad bucket count %s\n", argv[2]);
+      exit(1);
+    }
+    i = 3;
+  }
+
+  if(i >= argc){
+    fprintf(2, "Usage: mkdir [-h nbucket] files...\n");
+    exit(1);
+  }
+
+  for(; i < argc; i++){
+    if((nbucket ? hmkdir(argv[i], nbucket) : mkdir(argv[i])) < 0){
+      fprintf(2, "mkdir: %s failed to create\n", argv[i]);
+      break;
+    }
+  }
+
+  exit(0);
+}
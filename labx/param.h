@@ -0,0 +1,25 @@
+#define NPROC        64  // maximum number of processes
+#define NCPU          8  // maximum number of CPUs
+#define NOFILE       64  // open files per process
+#define NFILE       256  // open files per system
+#define NINODE       50  // maximum number of active i-nodes
+#define NDEV         10  // maximum major device number
+#define ROOTDEV       1  // device number of file system root disk
+#define MAXARG       32  // max exec arguments
+#define MAXOPBLOCKS  10  // max # of blocks any FS op writes
+#define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log，labx mkfs 默认的日志大小
+#define LOGMAX       64  // labx mkfs -l 最大的日志
+#define NRABUF       16    // labx readahead: 同时在读的预读 buf 最多几个
+#define NBUF         (LOGMAX*2+MAXOPBLOCKS*3+NRABUF)  // size of disk block cache，labx 提交中和正在攒的两个事务都 pin 着块，再多 NRABUF 个给预读
+#ifdef LAB_FS
+#define FSSIZE       200000  // size of file system in blocks
+#else
+#ifdef LAB_LOCK
+#define FSSIZE       10000  // size of file system in blocks
+#else
+#define FSSIZE       2000   // size of file system in blocks
+#endif
+#endif
+#define MAXPATH      128   // maximum file path name
+#define PIPESIZE     512   // labx pipe() 的缓冲区大小
+#define PIPEMAX      (16*4096) // labx pipe2() 最大的缓冲区
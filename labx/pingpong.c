@@ -0,0 +1,348 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+// pingpong
+// interaction between parent-child processes
+//
+// labx chan: pingpong -b [n] 做 n 次 4 字节的往返，
+// 分别用 pipe、chan 和 eventfd 传，比较总耗时
+//
+// labx pingpong: pingpong -l [-n 次数] [-s 消息大小] [-c same|cross] [-t pipe|chan]
+// 用 rdtime 量每次往返的时间，报告最小、中位数、p99、最大值，
+// 再单向连续发同样多的消息，报告吞吐量。-c same 把两个进程都绑在 CPU 0，
+// cross 分别绑在 CPU 0 和 1，默认不绑。-t 默认 pipe 和 chan 都测。
+
+void benchmark(int n);
+void latbench(int argc, char *argv[]);
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "-b") == 0) {
+        benchmark(argc >= 3 ? atoi(argv[2]) : 10000);
+        exit(0);
+    }
+    if (argc >= 2 && strcmp(argv[1], "-l") == 0) {
+        latbench(argc - 2, argv + 2);
+        exit(0);
+    }
+
+    int p_c_fds[2], c_p_fds[2];
+    pipe(p_c_fds);
+    pipe(c_p_fds);
+
+    char buf[16];
+
+    int pid = fork();
+    if (pid < 0) {
+        fprintf(2, "fork failed!\n");
+        exit(1);
+    } else if (pid == 0) {
+        close(p_c_fds[1]);
+        close(c_p_fds[0]);
+
+        // child read 
+        read (p_c_fds[0], buf, sizeof(buf));
+        close(p_c_fds[0]);
+        printf("%d: received %s\n", getpid(), buf); // 他必须按照格式罢了
+
+        // child write
+        write(c_p_fds[1], "pong", 4);
+        close(c_p_fds[1]);
+    } else {
+        close(p_c_fds[0]);
+        close(c_p_fds[1]);
+
+        // parent write
+        write(p_c_fds[1], "ping", 4);
+        close(p_c_fds[1]);
+
+        // parent read 
+        read (c_p_fds[0], buf, sizeof(buf));
+        close(c_p_fds[0]);
+        printf("%d: received %s\n", getpid(), buf);
+    }
+
+    exit(0);
+}
+
+// 用 pipe 往返 n 次，返回用掉的 ticks
+int pipe_rounds(int n) {
+    int p_c_fds[2], c_p_fds[2];
+    char buf[4] = "ping";
+
+    if (pipe(p_c_fds) < 0 || pipe(c_p_fds) < 0) {
+        fprintf(2, "pipe failed!\n");
+        exit(1);
+    }
+    int t0 = uptime();
+    if (fork() == 0) {
+        close(p_c_fds[1]);
+        close(c_p_fds[0]);
+        while (read(p_c_fds[0], buf, 4) == 4)
+            write(c_p_fds[1], buf, 4);
+        exit(0);
+    }
+    close(p_c_fds[0]);
+    close(c_p_fds[1]);
+    for (int i = 0; i < n; ++ i) {
+        write(p_c_fds[1], buf, 4);
+        read(c_p_fds[0], buf, 4);
+    }
+    close(p_c_fds[1]);
+    close(c_p_fds[0]);
+    wait(0);
+    return uptime() - t0;
+}
+
+// 用两个 chan 往返 n 次，返回用掉的 ticks
+int chan_rounds(int n) {
+    struct chan *p_c, *c_p;
+    char buf[4] = "ping";
+
+    if ((p_c = chan_open()) == 0 || (c_p = chan_open()) == 0) {
+        fprintf(2, "chan_open failed!\n");
+        exit(1);
+    }
+    int t0 = uptime();
+    if (fork() == 0) {
+        while (chan_recv(p_c, buf, 4) == 4)
+            chan_send(c_p, buf, 4);
+        exit(0);
+    }
+    for (int i = 0; i < n; ++ i) {
+        chan_send(p_c, buf, 4);
+        chan_recv(c_p, buf, 4);
+    }
+    chan_close(p_c);
+    wait(0);
+    return uptime() - t0;
+}
+
+// labx eventfd: 只传唤醒不传数据，用两个 eventfd 往返 n 次
+int event_rounds(int n) {
+    int p_c, c_p;
+    uint64 v = 1;
+
+    if ((p_c = eventfd(0)) < 0 || (c_p = eventfd(0)) < 0) {
+        fprintf(2, "eventfd failed!\n");
+        exit(1);
+    }
+    int t0 = uptime();
+    if (fork() == 0) {
+        for (int i = 0; i < n; ++ i) {
+            read(p_c, &v, sizeof(v));
+            write(c_p, &v, sizeof(v));
+        }
+        exit(0);
+    }
+    for (int i = 0; i < n; ++ i) {
+        write(p_c, &v, sizeof(v));
+        read(c_p, &v, sizeof(v));
+    }
+    wait(0);
+    close(p_c);
+    close(c_p);
+    return uptime() - t0;
+}
+
+void benchmark(int n) {
+    printf("pingpong: %d round trips over pipe: %d ticks\n", n, pipe_rounds(n));
+    printf("pingpong: %d round trips over chan: %d ticks\n", n, chan_rounds(n));
+    printf("pingpong: %d round trips over eventfd: %d ticks\n", n, event_rounds(n));
+}
+
+// labx pingpong: 延迟和吞吐量
+
+#define MAXMSG  8192
+
+enum { ANY, SAME, CROSS };
+
+int usechan;
+int pfd[2][2];              // [0] 父到子，[1] 子到父
+struct chan *ch[2];
+char msg[MAXMSG];
+
+void xopen(void) {
+    if (usechan) {
+        if ((ch[0] = chan_open()) == 0 || (ch[1] = chan_open()) == 0) {
+            fprintf(2, "chan_open failed!\n");
+            exit(1);
+        }
+    } else if (pipe(pfd[0]) < 0 || pipe(pfd[1]) < 0) {
+        fprintf(2, "pipe failed!\n");
+        exit(1);
+    }
+}
+
+// 子进程 (child=1) 或父进程关掉自己不用的 pipe 端
+void xside(int child) {
+    if (!usechan) {
+        close(pfd[child][0]);
+        close(pfd[!child][1]);
+    }
+}
+
+void xsend(int d, char *buf, int n) {
+    if (usechan) {
+        chan_send(ch[d], buf, n);
+    } else {
+        write(pfd[d][1], buf, n);
+    }
+}
+
+// 收满 n 字节，对方关闭返回 0
+int xrecv(int d, char *buf, int n) {
+    int got, m;
+
+    for (got = 0; got < n; got += m) {
+        m = usechan ? chan_recv(ch[d], buf + got, n - got)
+                    : read(pfd[d][0], buf + got, n - got);
+        if (m <= 0) {
+            return 0;
+        }
+    }
+    return n;
+}
+
+void xclose(int d) {
+    if (usechan) {
+        chan_close(ch[d]);
+    } else {
+        close(pfd[d][1]);
+        close(pfd[!d][0]);
+    }
+}
+
+void place(int where, int child) {
+    int mask = 0;
+
+    if (where == SAME) {
+        mask = 1;
+    } else if (where == CROSS) {
+        mask = child ? 2 : 1;
+    }
+    if (mask && setaffinity(mask) < 0) {
+        fprintf(2, "pingpong: setaffinity(%d) failed, need more CPUs?\n", mask);
+        exit(1);
+    }
+}
+
+void sortlat(uint64 *v, int n) {
+    // shell sort，n 最多几万
+    int gap, i, j;
+    uint64 t;
+
+    for (gap = n / 2; gap > 0; gap /= 2) {
+        for (i = gap; i < n; i++) {
+            t = v[i];
+            for (j = i; j >= gap && v[j - gap] > t; j -= gap) {
+                v[j] = v[j - gap];
+            }
+            v[j] = t;
+        }
+    }
+}
+
+void printlat(char *what, uint64 t) {
+    // 微秒，保留一位小数
+    uint64 us10 = t * 10000000 / TIMEHZ;
+    printf("  %s %l (%l.%lus)", what, t, us10 / 10, us10 % 10);
+}
+
+void latrun(int n, int size, int where) {
+    uint64 *lat, t0, t1;
+    int i;
+
+    if ((lat = malloc(n * sizeof(uint64))) == 0) {
+        fprintf(2, "pingpong: out of memory\n");
+        exit(1);
+    }
+
+    // 往返延迟
+    xopen();
+    if (fork() == 0) {
+        place(where, 1);
+        xside(1);
+        while (xrecv(0, msg, size) == size) {
+            xsend(1, msg, size);
+        }
+        exit(0);
+    }
+    place(where, 0);
+    xside(0);
+    // 先热身一次，让子进程跑起来
+    xsend(0, msg, size);
+    xrecv(1, msg, size);
+    for (i = 0; i < n; i++) {
+        t0 = rdtime();
+        xsend(0, msg, size);
+        xrecv(1, msg, size);
+        lat[i] = rdtime() - t0;
+    }
+    xclose(0);
+    wait(0);
+    sortlat(lat, n);
+    printf("%s %d bytes round trip, time units:\n", usechan ? "chan" : "pipe", size);
+    printlat("min", lat[0]);
+    printlat("median", lat[n / 2]);
+    printlat("p99", lat[n * 99 / 100]);
+    printlat("max", lat[n - 1]);
+    printf("\n");
+    free(lat);
+
+    // 单向吞吐量：子进程收完后回一个字节
+    xopen();
+    if (fork() == 0) {
+        place(where, 1);
+        xside(1);
+        for (i = 0; i < n; i++) {
+            xrecv(0, msg, size);
+        }
+        xsend(1, msg, 1);
+        exit(0);
+    }
+    place(where, 0);
+    xside(0);
+    t0 = rdtime();
+    for (i = 0; i < n; i++) {
+        xsend(0, msg, size);
+    }
+    xrecv(1, msg, 1);
+    t1 = rdtime();
+    xclose(0);
+    wait(0);
+    printf("  stream %l bytes/sec\n", (uint64)n * size * TIMEHZ / (t1 - t0 + 1));
+
+    // 父进程恢复不绑 CPU
+    setaffinity(0);
+}
+
+void latbench(int argc, char *argv[]) {
+    int n = 1000, size = 4, where = ANY, which = 3;
+
+    for (int i = 0; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-n")) {
+            n = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "-s")) {
+            size = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "-c")) {
+            where = !strcmp(argv[i + 1], "same") ? SAME : !strcmp(argv[i + 1], "cross") ? CROSS : ANY;
+        } else if (!strcmp(argv[i], "-t")) {
+            which = !strcmp(argv[i + 1], "pipe") ? 1 : !strcmp(argv[i + 1], "chan") ? 2 : 3;
+        }
+    }
+    if (n < 1 || size < 1 || size > MAXMSG) {
+        fprintf(2, "usage: pingpong -l [-n iters] [-s size(1-%d)] [-c same|cross] [-t pipe|chan]\n", MAXMSG);
+        exit(1);
+    }
+    printf("pingpong: %d iterations, %d bytes, %s\n", n, size,
+           where == SAME ? "same cpu" : where == CROSS ? "cross cpu" : "any cpu");
+    if (which & 1) {
+        usechan = 0;
+        latrun(n, size, where);
+    }
+    if (which & 2) {
+        usechan = 1;
+        latrun(n, size, where);
+    }
+}
@@ -0,0 +1,306 @@
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "poll.h"
+
+// labx pipe2
+// 缓冲区不再是 struct pipe 里固定的 512 字节，而是 size 字节 (2 的幂)，
+// 分散在 npage 个物理页里，第 i 个字节在 page[(i%size)/PGSIZE] 里。
+// 读写按连续的一段整块 copyin/copyout，不再一次一个字节。
+#define PIPEPAGES (PIPEMAX/PGSIZE)
+
+struct pipe {
+  struct spinlock lock;
+  uint nread;     // number of bytes read
+  uint nwrite;    // number of bytes written
+  int readopen;   // read fd is still open
+  int writeopen;  // write fd is still open
+  uint size;      // 缓冲区大小，2 的幂
+  int npage;
+  char *page[PIPEPAGES];
+  int wbusy;      // splice 正在不持锁地往缓冲区里写
+  int rbusy;      // splice 正在不持锁地从缓冲区里读
+  struct waitq pollq; // 两端的 poll() 都登记在这里
+};
+
+static void
+pipefree(struct pipe *pi)
+{
+  for(int i = 0; i < pi->npage; i++)
+    kfree(pi->page[i]);
+  kfree((char*)pi);
+}
+
+// size 为 0 时用默认的 PIPESIZE，否则必须是 2 的幂，且不超过 PIPEMAX
+int
+pipealloc(struct file **f0, struct file **f1, int size)
+{
+  struct pipe *pi;
+
+  if(size == 0)
+    size = PIPESIZE;
+  if(size < 0 || size > PIPEMAX || (size & (size - 1)) != 0)
+    return -1;
+
+  pi = 0;
+  *f0 = *f1 = 0;
+  if((*f0 = filealloc()) == 0 || (*f1 = filealloc()) == 0)
+    goto bad;
+  if((pi = (struct pipe*)kalloc()) == 0)
+    goto bad;
+  pi->npage = 0;
+  for(; pi->npage * PGSIZE < size; pi->npage++){
+    if((pi->page[pi->npage] = kalloc()) == 0)
+      goto bad;
+  }
+  pi->size = size;
+  pi->readopen = 1;
+  pi->writeopen = 1;
+  pi->nwrite = 0;
+  pi->nread = 0;
+  pi->wbusy = 0;
+  pi->rbusy = 0;
+  pi->pollq.head = 0;
+  initlock(&pi->lock, "pipe");
+  (*f0)->type = FD_PIPE;
+  (*f0)->readable = 1;
+  (*f0)->writable = 0;
+  (*f0)->pipe = pi;
+  (*f1)->type = FD_PIPE;
+  (*f1)->readable = 0;
+  (*f1)->writable = 1;
+  (*f1)->pipe = pi;
+  return 0;
+
+ bad:
+  if(pi)
+    pipefree(pi);
+  if(*f0)
+    fileclose(*f0);
+  if(*f1)
+    fileclose(*f1);
+  return -1;
+}
+
+void
+pipeclose(struct pipe *pi, int writable)
+{
+  acquire(&pi->lock);
+  if(writable){
+    pi->writeopen = 0;
+    wakeup(&pi->nread);
+  } else {
+    pi->readopen = 0;
+    wakeup(&pi->nwrite);
+  }
+  pollwakeup(&pi->pollq);
+  if(pi->readopen == 0 && pi->writeopen == 0){
+    release(&pi->lock);
+    pipefree(pi);
+  } else
+    release(&pi->lock);
+}
+
+// 从序号 pos 开始，缓冲区里物理上连续的一段有多长 (不超过 n)，
+// *pp 指向这一段的开头
+static int
+pipechunk(struct pipe *pi, uint pos, int n, char **pp)
+{
+  uint off = pos & (pi->size - 1);
+  uint m = PGSIZE - off % PGSIZE;
+
+  if(m > pi->size - off)
+    m = pi->size - off;
+  if(n > m)
+    n = m;
+  *pp = pi->page[off / PGSIZE] + off % PGSIZE;
+  return n;
+}
+
+int
+pipewrite(struct pipe *pi, uint64 addr, int n)
+{
+  int i = 0, m;
+  char *p;
+  struct proc *pr = myproc();
+
+  acquire(&pi->lock);
+  while(i < n){
+    if(pi->readopen == 0 || pr->killed){
+      release(&pi->lock);
+      return -1;
+    }
+    if(pi->wbusy || pi->nwrite == pi->nread + pi->size){ //DOC: pipewrite-full
+      wakeup(&pi->nread);
+      pollwakeup(&pi->pollq);
+      sleep(&pi->nwrite, &pi->lock);
+    } else {
+      m = pi->size - (pi->nwrite - pi->nread);
+      if(m > n - i)
+        m = n - i;
+      m = pipechunk(pi, pi->nwrite, m, &p);
+      if(copyin(pr->pagetable, p, addr + i, m) == -1)
+        break;
+      pi->nwrite += m;
+      i += m;
+    }
+  }
+  wakeup(&pi->nread);
+  if(i > 0)
+    pollwakeup(&pi->pollq);
+  release(&pi->lock);
+
+  return i;
+}
+
+int
+piperead(struct pipe *pi, uint64 addr, int n)
+{
+  int i, m;
+  char *p;
+  struct proc *pr = myproc();
+
+  acquire(&pi->lock);
+  while(pi->rbusy || (pi->nread == pi->nwrite && pi->writeopen)){  //DOC: pipe-empty
+    if(pr->killed){
+      release(&pi->lock);
+      return -1;
+    }
+    sleep(&pi->nread, &pi->lock); //DOC: piperead-sleep
+  }
+  for(i = 0; i < n && pi->nread != pi->nwrite; i += m){  //DOC: piperead-copy
+    m = pi->nwrite - pi->nread;
+    if(m > n - i)
+      m = n - i;
+    m = pipechunk(pi, pi->nread, m, &p);
+    if(copyout(pr->pagetable, addr + i, p, m) == -1)
+      break;
+    pi->nread += m;
+  }
+  wakeup(&pi->nwrite);  //DOC: piperead-wakeup
+  if(i > 0)
+    pollwakeup(&pi->pollq);
+  release(&pi->lock);
+  return i;
+}
+
+// labx splice
+// 让 splice 直接在 pipe 的页上读写，不经过用户内存。
+// begin 等到有空间 (数据) 后占住写端 (读端)，返回一段物理上连续的
+// 缓冲区，调用者不持锁地填充 (取走) 它，再用 end 提交实际的字节数。
+// 占住期间同一端的 pipewrite/piperead 和别的 splice 会等待，
+// 另一端照常进行：它们只会让这一段之外的空间 (数据) 变多。
+
+// 最多 n 字节的空闲缓冲区，读端已关闭或被 kill 返回 -1
+int
+pipe_wbegin(struct pipe *pi, int n, char **pp)
+{
+  struct proc *pr = myproc();
+  int m;
+
+  acquire(&pi->lock);
+  for(;;){
+    if(pi->readopen == 0 || pr->killed){
+      release(&pi->lock);
+      return -1;
+    }
+    if(!pi->wbusy && pi->nwrite != pi->nread + pi->size)
+      break;
+    wakeup(&pi->nread);
+    pollwakeup(&pi->pollq);
+    sleep(&pi->nwrite, &pi->lock);
+  }
+  pi->wbusy = 1;
+  m = pi->size - (pi->nwrite - pi->nread);
+  if(m > n)
+    m = n;
+  m = pipechunk(pi, pi->nwrite, m, pp);
+  release(&pi->lock);
+  return m;
+}
+
+void
+pipe_wend(struct pipe *pi, int n)
+{
+  acquire(&pi->lock);
+  pi->nwrite += n;
+  pi->wbusy = 0;
+  wakeup(&pi->nread);
+  wakeup(&pi->nwrite);
+  pollwakeup(&pi->pollq);
+  release(&pi->lock);
+}
+
+// 最多 n 字节的数据；没有数据时 block 为 0 或写端已关闭返回 0，被 kill 返回 -1
+int
+pipe_rbegin(struct pipe *pi, int n, char **pp, int block)
+{
+  struct proc *pr = myproc();
+  int m;
+
+  acquire(&pi->lock);
+  for(;;){
+    if(pr->killed){
+      release(&pi->lock);
+      return -1;
+    }
+    if(!pi->rbusy){
+      if(pi->nread != pi->nwrite)
+        break;
+      if(!pi->writeopen || !block){
+        release(&pi->lock);
+        return 0;
+      }
+    }
+    sleep(&pi->nread, &pi->lock);
+  }
+  pi->rbusy = 1;
+  m = pi->nwrite - pi->nread;
+  if(m > n)
+    m = n;
+  m = pipechunk(pi, pi->nread, m, pp);
+  release(&pi->lock);
+  return m;
+}
+
+void
+pipe_rend(struct pipe *pi, int n)
+{
+  acquire(&pi->lock);
+  pi->nread += n;
+  pi->rbusy = 0;
+  wakeup(&pi->nwrite);
+  wakeup(&pi->nread);
+  pollwakeup(&pi->pollq);
+  release(&pi->lock);
+}
+
+// labx poll
+// 读端：有数据或写端已关闭时可读；写端：有空间时可写，读端关闭算出错
+int
+pipepoll(struct pipe *pi, int writable, struct pollent *e)
+{
+  int r = 0;
+
+  acquire(&pi->lock);
+  pollwait(&pi->pollq, e);
+  if(writable){
+    if(pi->readopen == 0)
+      r |= POLLERR;
+    else if(pi->nwrite != pi->nread + pi->size)
+      r |= POLLOUT;
+  } else {
+    if(pi->nread != pi->nwrite)
+      r |= POLLIN;
+    if(pi->writeopen == 0)
+      r |= POLLIN | POLLHUP;
+  }
+  release(&pi->lock);
+  return r;
+}
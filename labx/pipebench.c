@@ -0,0 +1,96 @@
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+// labx pipe2: 不同缓冲区大小的 pipe 吞吐量
+//   primes 式：每次 write 一个 4 字节的 int
+//   批量：每次 write 4096 字节
+// 以及 pingpong 式的 4 字节往返
+
+#define SMALLTOTAL (4*20000)
+#define BULKTOTAL  (2*1024*1024)
+#define NROUND     2000
+
+int sizes[] = { PIPESIZE, 4096, 16384, PIPEMAX };
+char buf[4096];
+
+// 子进程往 pipe 里写 total 字节，每次 chunk 字节；父进程读完，返回用掉的 ticks
+int
+stream(int size, int chunk, int total)
+{
+  int fds[2], n, got, t0;
+
+  if(pipe2(fds, size) < 0){
+    printf("pipebench: pipe2 %d failed\n", size);
+    exit(1);
+  }
+  t0 = uptime();
+  if(fork() == 0){
+    close(fds[0]);
+    for(n = 0; n < total; n += chunk){
+      if(write(fds[1], buf, chunk) != chunk)
+        exit(1);
+    }
+    exit(0);
+  }
+  close(fds[1]);
+  got = 0;
+  while((n = read(fds[0], buf, sizeof(buf))) > 0)
+    got += n;
+  close(fds[0]);
+  wait(0);
+  if(got != total){
+    printf("pipebench: got %d bytes instead of %d\n", got, total);
+    exit(1);
+  }
+  return uptime() - t0;
+}
+
+int
+pingpong(void)
+{
+  int p2c[2], c2p[2], i, t0;
+  char b[4];
+
+  if(pipe(p2c) < 0 || pipe(c2p) < 0){
+    printf("pipebench: pipe failed\n");
+    exit(1);
+  }
+  t0 = uptime();
+  if(fork() == 0){
+    close(p2c[1]);
+    close(c2p[0]);
+    while(read(p2c[0], b, 4) == 4)
+      write(c2p[1], b, 4);
+    exit(0);
+  }
+  close(p2c[0]);
+  close(c2p[1]);
+  for(i = 0; i < NROUND; i++){
+    if(write(p2c[1], b, 4) != 4 || read(c2p[0], b, 4) != 4){
+      printf("pipebench: pingpong failed\n");
+      exit(1);
+    }
+  }
+  close(p2c[1]);
+  close(c2p[0]);
+  wait(0);
+  return uptime() - t0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, t;
+
+  for(i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++){
+    t = stream(sizes[i], 4, SMALLTOTAL);
+    printf("pipebench: pipe %d bytes, 4-byte writes: %d bytes in %d ticks\n",
+           sizes[i], SMALLTOTAL, t);
+    t = stream(sizes[i], sizeof(buf), BULKTOTAL);
+    printf("pipebench: pipe %d bytes, %d-byte writes: %d bytes in %d ticks\n",
+           sizes[i], sizeof(buf), BULKTOTAL, t);
+  }
+  printf("pipebench: %d 4-byte pingpong round trips: %d ticks\n", NROUND, pingpong());
+  exit(0);
+}
@@ -0,0 +1,155 @@
+// labx poll
+// poll() 不在每次醒来时重新扫描所有 fd 去登记，而是第一遍扫描时
+// 在每个文件的等待队列上挂一个 pollent，之后由文件状态变化时
+// 的 pollwakeup() 直接叫醒；超时则挂在时钟的等待队列上。
+
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "poll.h"
+
+// 所有等待队列共用一把锁，pollwaiter.woken 也由它保护
+struct spinlock polllock;
+
+// 每个时钟中断都会唤醒，给带超时的 poll() 用
+struct waitq tickq;
+
+struct pollwaiter {
+  int woken;
+};
+
+// 一次 poll() 用的一页：拷进来的 pollfd 和每个 fd (以及时钟) 的登记
+struct pollpage {
+  struct pollfd fds[NOFILE];
+  struct pollent ent[NOFILE+1];
+};
+
+void
+pollinit(void)
+{
+  initlock(&polllock, "poll");
+}
+
+// 把 e 挂到 q 上，文件的 poll 函数在第一遍扫描时调用
+void
+pollwait(struct waitq *q, struct pollent *e)
+{
+  if(e == 0 || e->q != 0)
+    return;
+  acquire(&polllock);
+  e->q = q;
+  e->next = q->head;
+  q->head = e;
+  release(&polllock);
+}
+
+// q 上的状态变了，叫醒所有在上面登记过的 poll()
+void
+pollwakeup(struct waitq *q)
+{
+  struct pollent *e;
+
+  acquire(&polllock);
+  for(e = q->head; e; e = e->next){
+    e->w->woken = 1;
+    wakeup(e->w);
+  }
+  release(&polllock);
+}
+
+static void
+pollunwait(struct pollent *e)
+{
+  struct pollent **pp;
+
+  if(e->q == 0)
+    return;
+  for(pp = &e->q->head; *pp; pp = &(*pp)->next){
+    if(*pp == e){
+      *pp = e->next;
+      break;
+    }
+  }
+  e->q = 0;
+}
+
+// 等到 fds[0..n) 里至少有一个 fd 就绪，或者过了 timeout 个 tick
+// (timeout < 0 一直等，0 不等)。返回就绪的 fd 个数，超时返回 0，
+// revents 写回用户的 fds。
+int
+poll(uint64 ufds, int n, int timeout)
+{
+  struct proc *p = myproc();
+  struct pollpage *pg;
+  struct pollwaiter w;
+  struct pollfd *pfd;
+  struct file *f;
+  uint deadline = 0;
+  int i, ready, first;
+
+  if(n < 0 || n > NOFILE)
+    return -1;
+  if((pg = (struct pollpage*)kalloc()) == 0)
+    return -1;
+  if(copyin(p->pagetable, (char*)pg->fds, ufds, n*sizeof(struct pollfd)) < 0){
+    kfree((char*)pg);
+    return -1;
+  }
+  for(i = 0; i <= n; i++){
+    pg->ent[i].q = 0;
+    pg->ent[i].w = &w;
+  }
+
+  if(timeout > 0){
+    acquire(&tickslock);
+    deadline = ticks + timeout;
+    release(&tickslock);
+    pollwait(&tickq, &pg->ent[n]);
+  }
+
+  for(first = 1;; first = 0){
+    acquire(&polllock);
+    w.woken = 0;
+    release(&polllock);
+
+    ready = 0;
+    for(i = 0; i < n; i++){
+      pfd = &pg->fds[i];
+      if(pfd->fd < 0 || pfd->fd >= NOFILE || (f = p->ofile[pfd->fd]) == 0){
+        pfd->revents = POLLNVAL;
+      } else {
+        pfd->revents = filepoll(f, pfd->events, first ? &pg->ent[i] : 0);
+        pfd->revents &= pfd->events | POLLERR | POLLHUP;
+      }
+      if(pfd->revents)
+        ready++;
+    }
+    if(ready || timeout == 0 || p->killed)
+      break;
+    if(timeout > 0 && (int)(ticks - deadline) >= 0)
+      break;
+
+    acquire(&polllock);
+    while(!w.woken && !p->killed)
+      sleep(&w, &polllock);
+    release(&polllock);
+  }
+
+  acquire(&polllock);
+  for(i = 0; i <= n; i++)
+    pollunwait(&pg->ent[i]);
+  release(&polllock);
+
+  if(p->killed)
+    ready = -1;
+  else if(copyout(p->pagetable, ufds, (char*)pg->fds, n*sizeof(struct pollfd)) < 0)
+    ready = -1;
+  kfree((char*)pg);
+  return ready;
+}
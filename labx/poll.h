@@ -0,0 +1,24 @@
+// labx poll
+// poll(fds, n, timeout) 的参数，以及内核里登记等待者用的等待队列
+
+#define POLLIN    0x001   // 可以读 (或者读到文件尾)
+#define POLLOUT   0x004   // 可以写
+#define POLLERR   0x008   // 出错，比如 pipe 的读端已经关了
+#define POLLHUP   0x010   // 对方关闭了
+#define POLLNVAL  0x020   // fd 没有打开
+
+struct pollfd {
+  int fd;
+  short events;           // 关心的事件
+  short revents;          // 发生的事件，由内核填写
+};
+
+// 一次 poll() 调用在某个等待队列上的登记，
+// 放在 poll() 自己分配的页里，返回前全部摘掉
+struct pollent {
+  struct waitq *q;
+  struct pollwaiter *w;
+  struct pollent *next;
+};
+
+// struct waitq 在 file.h 里，struct file 也要用
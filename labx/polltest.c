@@ -0,0 +1,145 @@
+#include "kernel/types.h"
+#include "kernel/poll.h"
+#include "user/user.h"
+
+// labx poll: 一个进程用 poll 同时收 NCHILD 个子进程的输出
+
+#define NCHILD 32
+
+void
+testfanin()
+{
+  struct pollfd fds[NCHILD];
+  int p[2], i, n, left, got[NCHILD];
+  char c;
+
+  for(i = 0; i < NCHILD; i++){
+    if(pipe(p) < 0){
+      printf("polltest: pipe failed\n");
+      exit(1);
+    }
+    if(fork() == 0){
+      close(p[0]);
+      sleep(i % 4);
+      c = i;
+      write(p[1], &c, 1);
+      exit(0);
+    }
+    close(p[1]);
+    fds[i].fd = p[0];
+    fds[i].events = POLLIN;
+    got[i] = 0;
+  }
+
+  left = NCHILD;
+  while(left > 0){
+    if((n = poll(fds, NCHILD, -1)) <= 0){
+      printf("polltest: FAIL poll returned %d\n", n);
+      exit(1);
+    }
+    for(i = 0; i < NCHILD; i++){
+      if(fds[i].fd < 0 || fds[i].revents == 0)
+        continue;
+      if(read(fds[i].fd, &c, 1) == 1){
+        if(c != i){
+          printf("polltest: FAIL got %d on pipe %d\n", c, i);
+          exit(1);
+        }
+        got[i]++;
+      } else {
+        // 写端关了
+        close(fds[i].fd);
+        fds[i].fd = -1;
+        left--;
+      }
+    }
+  }
+  for(i = 0; i < NCHILD; i++){
+    wait(0);
+    if(got[i] != 1){
+      printf("polltest: FAIL pipe %d got %d bytes\n", i, got[i]);
+      exit(1);
+    }
+  }
+}
+
+void
+testtimeout()
+{
+  struct pollfd fds[2];
+  int p[2], n;
+
+  pipe(p);
+  fds[0].fd = p[0];
+  fds[0].events = POLLIN;
+  fds[1].fd = p[1];
+  fds[1].events = 0;
+  if((n = poll(fds, 2, 3)) != 0){
+    printf("polltest: FAIL timeout poll returned %d\n", n);
+    exit(1);
+  }
+  fds[1].events = POLLOUT;
+  if(poll(fds, 2, 0) != 1 || fds[1].revents != POLLOUT || fds[0].revents != 0){
+    printf("polltest: FAIL pipe should be writable only\n");
+    exit(1);
+  }
+  fds[0].fd = 99;
+  if(poll(fds, 1, 0) != 1 || fds[0].revents != POLLNVAL){
+    printf("polltest: FAIL bad fd\n");
+    exit(1);
+  }
+  close(p[0]);
+  close(p[1]);
+}
+
+// labx eventfd: 计数器累加、读后清零，以及 poll
+void
+testeventfd()
+{
+  struct pollfd pfd;
+  uint64 v;
+  int fd;
+
+  if((fd = eventfd(0)) < 0){
+    printf("polltest: eventfd failed\n");
+    exit(1);
+  }
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  if(poll(&pfd, 1, 0) != 0){
+    printf("polltest: FAIL empty eventfd is readable\n");
+    exit(1);
+  }
+  if(fork() == 0){
+    v = 2;
+    write(fd, &v, sizeof(v));
+    v = 3;
+    write(fd, &v, sizeof(v));
+    exit(0);
+  }
+  wait(0);
+  if(poll(&pfd, 1, -1) != 1 || pfd.revents != POLLIN){
+    printf("polltest: FAIL eventfd not readable\n");
+    exit(1);
+  }
+  if(read(fd, &v, sizeof(v)) != sizeof(v) || v != 5){
+    printf("polltest: FAIL eventfd read %d\n", (int)v);
+    exit(1);
+  }
+  if(poll(&pfd, 1, 0) != 0){
+    printf("polltest: FAIL eventfd not cleared\n");
+    exit(1);
+  }
+  close(fd);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf("polltest: start\n");
+  testfanin();
+  testtimeout();
+  testeventfd();
+  printf("polltest: OK\n");
+  exit(0);
+}
@@ -0,0 +1,229 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+// labx primes
+// primes [-v] [N [batch [depth]]]
+// 不带参数时和 lab1 一样，筛到 35 并打印每个质数。
+// N：筛到 N；batch：每次 write 最多带几个数 (默认 1，和原来一样一次一个)；
+// depth：最多几个进程组成流水线 (默认 32)，之后的数在最后一个进程里直接试除。
+// 带参数时只打印找到的质数个数和用掉的 ticks，-v 同时打印每个质数。
+//
+// lab1 的版本每一级先把所有数都读完再 fork 下一级，N 一大下一级的 pipe
+// 就会被写满；这里每一级拿到第一个幸存的数就 fork 下一级，各级同时运行。
+// 每一级的退出状态是它和后面各级找到的质数个数。
+
+#define MAXBATCH 4096
+
+int batch = 1;
+int depth = 32;
+int verbose;
+
+// pipe 可能只给半个 int，剩下的字节留在 carry 里下次接着用
+struct in {
+    int fd;
+    int nc;
+    char carry[sizeof(int)];
+};
+
+void *xmalloc(int n) {
+    void *p = malloc(n);
+    if (p == 0) {
+        fprintf(2, "primes: out of memory\n");
+        exit(-1);
+    }
+    return p;
+}
+
+// 读至多 max 个 int 到 v，返回个数，0 表示读完了
+int readints(struct in *in, int *v, int max) {
+    char *p = (char *)v;
+    int n, got;
+
+    memmove(p, in->carry, in->nc);
+    got = in->nc;
+    while (got < sizeof(int)) {
+        if ((n = read(in->fd, p + got, max * sizeof(int) - got)) <= 0) {
+            return 0;
+        }
+        got += n;
+    }
+    in->nc = got % sizeof(int);
+    memmove(in->carry, p + got - in->nc, in->nc);
+    return got / sizeof(int);
+}
+
+void report(int p) {
+    if (verbose) {
+        printf("prime %d\n", p);
+    }
+}
+
+// 流水线的最后一级：用本级已经找到的质数试除，不再 fork
+int sieve(struct in *in, int *v) {
+    int *found = 0, nfound = 0, maxfound = 0;
+    int n, i, j, c;
+
+    while ((n = readints(in, v, batch)) > 0) {
+        for (i = 0; i < n; i++) {
+            c = v[i];
+            // 前面各级已经筛掉了更小的质因子，c 的最小质因子如果 <= sqrt(c)，一定在 found 里
+            int composite = 0;
+            for (j = 0; j < nfound && found[j] <= c / found[j]; j++) {
+                if (c % found[j] == 0) {
+                    composite = 1;
+                    break;
+                }
+            }
+            if (composite) {
+                continue;
+            }
+            report(c);
+            if (nfound == maxfound) {
+                int *nf = xmalloc((maxfound = maxfound ? maxfound * 2 : 64) * sizeof(int));
+                memmove(nf, found, nfound * sizeof(int));
+                free(found);
+                found = nf;
+            }
+            found[nfound++] = c;
+        }
+    }
+    free(found);
+    return nfound;
+}
+
+int stage(int fd, int level);
+
+// 流水线的一级：第一个数是质数 p，不能被 p 整除的攒成一批写给下一级
+int filter(struct in *in, int *v, int level) {
+    int *out = xmalloc(batch * sizeof(int));
+    int fds[2], wfd = -1, pid = -1, nout = 0;
+    int n, i, c, p = 0, count;
+
+    while ((n = readints(in, v, batch)) > 0) {
+        for (i = 0; i < n; i++) {
+            c = v[i];
+            if (p == 0) {
+                p = c;
+                report(p);
+                continue;
+            }
+            if (c % p == 0) {
+                continue;
+            }
+            // 第一个幸存的数来了才创建下一级
+            if (pid < 0) {
+                if (pipe(fds) < 0 || (pid = fork()) < 0) {
+                    fprintf(2, "primes: pipe/fork failed at level %d, try a smaller depth\n", level);
+                    exit(-1);
+                }
+                if (pid == 0) {
+                    close(in->fd);
+                    close(fds[1]);
+                    exit(stage(fds[0], level + 1));
+                }
+                close(fds[0]);
+                wfd = fds[1];
+            }
+            out[nout++] = c;
+            if (nout == batch) {
+                write(wfd, out, nout * sizeof(int));
+                nout = 0;
+            }
+        }
+    }
+    if (nout > 0) {
+        write(wfd, out, nout * sizeof(int));
+    }
+    free(out);
+    if (p == 0) {
+        return 0;
+    }
+    if (pid < 0) {
+        return 1;
+    }
+    close(wfd);
+    wait(&count);
+    return 1 + count;
+}
+
+int stage(int fd, int level) {
+    struct in in;
+    int *v = xmalloc(batch * sizeof(int));
+    int count;
+
+    in.fd = fd;
+    in.nc = 0;
+    if (level >= depth) {
+        count = sieve(&in, v);
+    } else {
+        count = filter(&in, v, level);
+    }
+    close(fd);
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+
+    int n = 35, args = argc > 1;
+
+    verbose = !args;
+    if (argc > 1 && !strcmp(argv[1], "-v")) {
+        verbose = 1;
+        argv++;
+        argc--;
+    }
+    if (argc > 1) {
+        n = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        batch = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        depth = atoi(argv[3]);
+    }
+    if (batch < 1 || batch > MAXBATCH || depth < 0) {
+        fprintf(2, "usage: primes [-v] [N [batch(1-%d) [depth]]]\n", MAXBATCH);
+        exit(1);
+    }
+
+    int fds[2]; // 主进程创建一个管道
+    if (pipe(fds) < 0) {
+        fprintf(2, "primes: pipe failed\n");
+        exit(1);
+    }
+
+    int t0 = uptime();
+    int pid = fork();
+    if (pid < 0) {
+        fprintf(2, "primes: fork failed\n");
+        exit(1);
+    }
+    if (pid == 0) {
+        close(fds[1]);
+        exit(stage(fds[0], 0));
+    }
+    close(fds[0]);
+
+    // 主进程是生成器，每 batch 个数写一次
+    int *out = xmalloc(batch * sizeof(int)), nout = 0;
+    for (int i = 2; i <= n; ++ i) {
+        out[nout++] = i;
+        if (nout == batch) {
+            write(fds[1], out, nout * sizeof(int));
+            nout = 0;
+        }
+    }
+    if (nout > 0) {
+        write(fds[1], out, nout * sizeof(int));
+    }
+    close(fds[1]);  // 关闭 write 端
+
+    int count;
+    wait(&count);
+    if (args) {
+        printf("primes: n=%d batch=%d depth=%d: %d primes, %d ticks\n",
+               n, batch, depth, count, uptime() - t0);
+    }
+    exit(0);
+}
@@ -0,0 +1,269 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+#include <stdarg.h>
+
+// labx printf
+// 每个 fd 有一个输出缓冲区 (第一次输出时 malloc)，满了才 write；
+// 终端在每次 printf 结束时如果输出过换行就刷出去，fd 2 不缓冲。
+// exit/fork/exec/spawn/close 之前会把缓冲区刷掉，见下面的包装函数。
+// clone() 出来的线程共用这些缓冲区，所以都在 obuflock (thread.c 的 mutex) 里访问。
+
+#define OBUFSIZE 512
+
+struct obuf {
+  int fd;
+  int n;
+  int tty;          // fd 是终端，换行就刷
+  int nl;           // 这次 printf 输出过换行
+  char buf[OBUFSIZE];
+};
+
+static struct obuf *obufs[NOFILE];
+static char unbuffered[NOFILE];   // setbuffered(fd, 0) 关掉了缓冲
+static struct mutex obuflock;     // 保护 obufs[]、unbuffered[] 和缓冲区的内容
+
+static char digits[] = "0123456789ABCDEF";
+
+static void
+flush(struct obuf *b)
+{
+  if(b->n > 0)
+    write(b->fd, b->buf, b->n);
+  b->n = 0;
+  b->nl = 0;
+}
+
+static void
+putc(struct obuf *b, char c)
+{
+  b->buf[b->n++] = c;
+  if(c == '\n')
+    b->nl = 1;
+  if(b->n == OBUFSIZE)
+    flush(b);
+}
+
+// fd 的缓冲区，不缓冲的 fd 返回 0。调用者持有 obuflock。
+static struct obuf*
+getbuf(int fd)
+{
+  struct obuf *b;
+  struct stat st;
+
+  if(fd < 0 || fd >= NOFILE || fd == 2 || unbuffered[fd])
+    return 0;
+  if((b = obufs[fd]) != 0)
+    return b;
+  if((b = malloc(sizeof(*b))) == 0)
+    return 0;
+  b->fd = fd;
+  b->n = 0;
+  b->nl = 0;
+  b->tty = fstat(fd, &st) == 0 && st.type == T_DEVICE;
+  obufs[fd] = b;
+  return b;
+}
+
+static void
+printint(struct obuf *b, long xx, int base, int sgn)
+{
+  char buf[24];
+  int i, neg;
+  uint64 x;
+
+  neg = 0;
+  if(sgn && xx < 0){
+    neg = 1;
+    x = -xx;
+  } else {
+    x = xx;
+  }
+
+  i = 0;
+  do{
+    buf[i++] = digits[x % base];
+  }while((x /= base) != 0);
+  if(neg)
+    buf[i++] = '-';
+
+  while(--i >= 0)
+    putc(b, buf[i]);
+}
+
+static void
+printptr(struct obuf *b, uint64 x) {
+  int i;
+  putc(b, '0');
+  putc(b, 'x');
+  for (i = 0; i < (sizeof(uint64) * 2); i++, x <<= 4)
+    putc(b, digits[x >> (sizeof(uint64) * 8 - 4)]);
+}
+
+// Print to the given fd. Only understands %d, %x, %p, %s.
+void
+vprintf(int fd, const char *fmt, va_list ap)
+{
+  char *s;
+  int c, i, state;
+  struct obuf tmp, *b;
+
+  mutex_lock(&obuflock);
+  // 不缓冲的 fd 也至少把一次 printf 攒成一个 write
+  if((b = getbuf(fd)) == 0){
+    b = &tmp;
+    b->fd = fd;
+    b->n = 0;
+    b->nl = 0;
+  }
+
+  state = 0;
+  for(i = 0; fmt[i]; i++){
+    c = fmt[i] & 0xff;
+    if(state == 0){
+      if(c == '%'){
+        state = '%';
+      } else {
+        putc(b, c);
+      }
+    } else if(state == '%'){
+      if(c == 'd'){
+        printint(b, va_arg(ap, int), 10, 1);
+      } else if(c == 'l') {
+        // labx pingpong: %l 按完整的 64 位打印，不再截成 int
+        printint(b, va_arg(ap, uint64), 10, 0);
+      } else if(c == 'x') {
+        printint(b, va_arg(ap, uint), 16, 0);
+      } else if(c == 'p') {
+        printptr(b, va_arg(ap, uint64));
+      } else if(c == 's'){
+        s = va_arg(ap, char*);
+        if(s == 0)
+          s = "(null)";
+        while(*s != 0){
+          putc(b, *s);
+          s++;
+        }
+      } else if(c == 'c'){
+        putc(b, va_arg(ap, uint));
+      } else if(c == '%'){
+        putc(b, c);
+      } else {
+        // Unknown % sequence.  Print it to draw attention.
+        putc(b, '%');
+        putc(b, c);
+      }
+      state = 0;
+    }
+  }
+
+  if(b == &tmp || (b->tty && b->nl))
+    flush(b);
+  mutex_unlock(&obuflock);
+}
+
+void
+fprintf(int fd, const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vprintf(fd, fmt, ap);
+}
+
+void
+printf(const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  vprintf(1, fmt, ap);
+}
+
+// 调用者持有 obuflock
+static void
+flushfd(int fd)
+{
+  if(fd >= 0 && fd < NOFILE && obufs[fd])
+    flush(obufs[fd]);
+}
+
+// 把 fd 缓冲的输出写出去
+void
+fflush(int fd)
+{
+  mutex_lock(&obuflock);
+  flushfd(fd);
+  mutex_unlock(&obuflock);
+}
+
+// on 为 0 时 fd 不再缓冲，每次 printf 直接 write
+void
+setbuffered(int fd, int on)
+{
+  if(fd < 0 || fd >= NOFILE)
+    return;
+  mutex_lock(&obuflock);
+  flushfd(fd);
+  unbuffered[fd] = !on;
+  mutex_unlock(&obuflock);
+}
+
+static void
+flushall(void)
+{
+  mutex_lock(&obuflock);
+  for(int fd = 0; fd < NOFILE; fd++)
+    flushfd(fd);
+  mutex_unlock(&obuflock);
+}
+
+// usys.S 里的 exit/fork/exec/spawn/close 是弱符号，
+// 链接了 printf.o 的程序用下面这些先刷缓冲区的版本
+
+int
+exit(int status)
+{
+  flushall();
+  _exit(status);
+}
+
+// 不刷的话子进程会带着一份没写出去的输出
+int
+fork(void)
+{
+  flushall();
+  return _fork();
+}
+
+int
+exec(char *path, char **argv)
+{
+  flushall();
+  return _exec(path, argv);
+}
+
+// 子进程可能和我们写同一个 fd，先把前面的输出写出去
+int
+spawn(char *path, char **argv, struct spawn_action *acts, int nact)
+{
+  flushall();
+  return _spawn(path, argv, acts, nact);
+}
+
+// fd 关掉以后可能被别的文件复用，缓冲区跟着丢掉
+int
+close(int fd)
+{
+  mutex_lock(&obuflock);
+  if(fd >= 0 && fd < NOFILE && obufs[fd]){
+    flush(obufs[fd]);
+    free(obufs[fd]);
+    obufs[fd] = 0;
+  }
+  mutex_unlock(&obuflock);
+  lineclose(fd);
+  return _close(fd);
+}
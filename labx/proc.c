@@ -0,0 +1,1198 @@
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+#include "spawn.h"
+
+struct cpu cpus[NCPU];
+
+struct proc proc[NPROC];
+
+// labx clone: 被线程共享的地址空间
+struct vmspace vmspace[NPROC];
+
+struct proc *initproc;
+
+int nextpid = 1;
+struct spinlock pid_lock;
+
+extern void forkret(void);
+static void freeproc(struct proc *p);
+static void proc_putpagetable(pagetable_t pagetable, uint64 sz, struct vmspace *vm, uint64 tfva);
+
+extern char trampoline[]; // trampoline.S
+
+// helps ensure that wakeups of wait()ing
+// parents are not lost. helps obey the
+// memory model when using p->parent.
+// must be acquired before any p->lock.
+struct spinlock wait_lock;
+
+// Allocate a page for each process's kernel stack.
+// Map it high in memory, followed by an invalid
+// guard page.
+// 为每个进程的内核栈分配一个页
+void
+proc_mapstacks(pagetable_t kpgtbl) {
+  struct proc *p;
+  
+  for(p = proc; p < &proc[NPROC]; p++) {
+    char *pa = kalloc();
+    if(pa == 0)
+      panic("kalloc");
+    uint64 va = KSTACK((int) (p - proc));
+    kvmmap(kpgtbl, va, (uint64)pa, PGSIZE, PTE_R | PTE_W);
+  }
+}
+
+// initialize the proc table at boot time.
+void
+procinit(void)
+{
+  struct proc *p;
+  struct vmspace *vm;
+  
+  initlock(&pid_lock, "nextpid");
+  initlock(&wait_lock, "wait_lock");
+  for(p = proc; p < &proc[NPROC]; p++) {
+      initlock(&p->lock, "proc");
+      p->kstack = KSTACK((int) (p - proc));
+  }
+  for(vm = vmspace; vm < &vmspace[NPROC]; vm++)
+      initlock(&vm->lock, "vmspace");
+}
+
+// Must be called with interrupts disabled,
+// to prevent race with process being moved
+// to a different CPU.
+int
+cpuid()
+{
+  int id = r_tp();
+  return id;
+}
+
+// Return this CPU's cpu struct.
+// Interrupts must be disabled.
+struct cpu*
+mycpu(void) {
+  int id = cpuid();
+  struct cpu *c = &cpus[id];
+  return c;
+}
+
+// Return the current struct proc *, or zero if none.
+struct proc*
+myproc(void) {
+  push_off();
+  struct cpu *c = mycpu();
+  struct proc *p = c->proc;
+  pop_off();
+  return p;
+}
+
+// 分配该进程的 pid， called in allocproc()
+int
+allocpid() {
+  int pid;
+  
+  acquire(&pid_lock);
+  pid = nextpid;
+  nextpid = nextpid + 1;
+  release(&pid_lock);
+
+  return pid;
+}
+
+// Look in the process table for an UNUSED proc.
+// If found, initialize state required to run in the kernel, and return with p->lock held.
+// If there are no free procs, or a memory allocation fails, return 0.
+// 在进程表中查找未使用的进程，创建新进程
+// thread 非 0 时是给 clone() 用的：不分配 USYSCALL 页和页表，由调用者共享创建者的
+static struct proc*
+allocproc(int thread)
+{
+  struct proc *p;
+
+  // 遍历所有的进程，找到空闲的
+  for(p = proc; p < &proc[NPROC]; p++) {
+    acquire(&p->lock);        // 上锁
+    if(p->state == UNUSED) {
+      goto found;             // 找到了，去分配内存
+    } else {
+      release(&p->lock);      // 没找到，释放锁并返回
+    }
+  }
+  return 0;
+
+// 找到了空闲的进程，goto 来到这里
+found:
+  p->pid = allocpid();
+  p->state = USED;
+
+  // Allocate a trapframe page.
+  // 分配 trapframe page
+  if((p->trapframe = (struct trapframe *)kalloc()) == 0){
+    freeproc(p);
+    release(&p->lock);
+    return 0;
+  }
+
+  if(!thread){
+    // 初始化我写的 upid，给他分配一个页
+    if((p->mypid = (struct usyscall *)kalloc()) == 0){
+      freeproc(p);
+      release(&p->lock);
+      return 0;
+    }
+    p->mypid->pid = p->pid;
+
+    // An empty user page table.
+    // 为新进程创建用户页表
+    p->tfva = TRAPFRAME;
+    p->pagetable = proc_pagetable(p);
+    if(p->pagetable == 0){
+      freeproc(p);
+      release(&p->lock);
+      return 0;
+    }
+  }
+
+  // Set up new context to start executing at forkret,
+  // which returns to user space.
+  memset(&p->context, 0, sizeof(p->context));
+  p->context.ra = (uint64)forkret;
+  p->context.sp = p->kstack + PGSIZE;
+
+  return p;
+}
+
+// free a proc structure and the data hanging from it,
+// including user pages.
+// p->lock must be held.
+static void
+freeproc(struct proc *p)
+{
+  // 释放 trampframe 的页
+  if(p->trapframe) {
+    kfree((void*)p->trapframe);
+  }
+  p->trapframe = 0;
+
+  // 释放 read-only 共享区域的页
+  if(p->mypid) {
+    kfree((void*)p->mypid);
+  }
+  p->mypid = 0;
+
+  // 解除页表中所有的映射，释放内存
+  // 和线程共享的页表只有最后一个使用者才会真正释放
+  if(p->pagetable) {
+    proc_putpagetable(p->pagetable, p->sz, p->vm, p->tfva);
+  }
+  p->pagetable = 0;
+  p->vm = 0;
+  p->tfva = 0;
+  p->ustack = 0;
+
+  // 洗干净其他参数
+  p->sz = 0;
+  p->pid = 0;
+  p->parent = 0;
+  p->name[0] = 0;
+  p->chan = 0;
+  p->killed = 0;
+  p->xstate = 0;
+  p->mask = 0;
+  p->cpumask = 0;
+  p->state = UNUSED;
+}
+
+// Create a user page table for a given process, with no user memory, but with trampoline pages.
+// 为进程 p 创建一个用户页表做映射，但是不包含用户内存
+// called in allocproc()
+pagetable_t
+proc_pagetable(struct proc *p)
+{
+  pagetable_t pagetable;
+
+  // An empty page table.
+  // 创建一个空的页表
+  pagetable = uvmcreate();    
+  if(pagetable == 0)
+    return 0;
+
+  // map the trampoline code (for system call return) at the highest user virtual address.
+  // only the supervisor uses it, on the way to/from user space, so not PTE_U.
+  // 映射 trampoline，在用户地址空间的顶部
+  if(mappages(pagetable, TRAMPOLINE, PGSIZE, (uint64)trampoline, PTE_R | PTE_X) < 0){
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
+  // map the trapframe just below TRAMPOLINE, for trampoline.S.
+  // 映射 trapframe，紧跟着在 trampoline 下面
+  if(mappages(pagetable, TRAPFRAME, PGSIZE, (uint64)(p->trapframe), PTE_R | PTE_W) < 0){
+    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
+  // 加速页表索引，因为有些系统调用共享同一份只读代码，例如 getpid()
+
+  // 在每个进程被创建的时候，将一个 read-only 的页映射到 USYSCALL (defined in memlayout.h)
+  // #define MAXVA (1L << (9 + 9 + 9 + 12 - 1))
+  // #define TRAMPOLINE (MAXVA - PGSIZE)   // 在每个进程内核栈栈顶往下数一个 PGSIZE
+  // #define TRAPFRAME (TRAMPOLINE - PGSIZE)   // trampline 往下数一个 PGSIZE
+  // #define USYSCALL (TRAPFRAME - PGSIZE)     // trapframe 往下数一个 PGSIZE，该页是 read-only
+
+  // int mappages(pagetable_t pagetable, uint64 va, uint64 size, uint64 pa, int perm)
+  if(mappages(pagetable, USYSCALL, PGSIZE, (uint64)(p->mypid), PTE_R | PTE_U) < 0){     // read-only + user accessible
+    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+    uvmunmap(pagetable, TRAPFRAME, 1, 0);
+    uvmfree(pagetable, 0);
+    return 0;
+  }
+
+  return pagetable;
+}
+
+// Free a process's page table, and free the physical memory it refers to.
+// 解除用户页表的映射，并且释放其对应的物理内存
+void
+proc_freepagetable(pagetable_t pagetable, uint64 sz)
+{
+  uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+  uvmunmap(pagetable, TRAPFRAME, 1, 0);
+  uvmunmap(pagetable, USYSCALL, 1, 0);    // 解除映射
+  uvmfree(pagetable, sz);
+}
+
+// labx clone
+// 第一次 clone() 时为 p 的地址空间分配一个 vmspace，
+// 之后 p 的 USYSCALL 页归地址空间所有。
+// 返回时持有 vm->lock。
+static struct vmspace*
+vmspace_get(struct proc *p)
+{
+  struct vmspace *vm;
+
+  if((vm = p->vm) != 0){
+    acquire(&vm->lock);
+    return vm;
+  }
+
+  for(vm = vmspace; vm < &vmspace[NPROC]; vm++){
+    acquire(&vm->lock);
+    if(vm->ref == 0){
+      vm->ref = 1;
+      vm->slots = 1;                  // 槽位 0 (TRAPFRAME) 是 p 自己的
+      vm->sz = p->sz;
+      vm->usyscall = p->mypid;
+      p->mypid = 0;
+      p->vm = vm;
+      return vm;
+    }
+    release(&vm->lock);
+  }
+  return 0;
+}
+
+// 释放对一个地址空间的引用，freeproc() 和 exec() 调用。
+// 私有的页表直接释放；共享的页表只解除自己 trapframe 的映射，
+// 最后一个使用者再把 trampoline、USYSCALL 和用户内存一起释放。
+static void
+proc_putpagetable(pagetable_t pagetable, uint64 sz, struct vmspace *vm, uint64 tfva)
+{
+  int last;
+  uint64 n;
+  struct usyscall *usyscall;
+
+  if(vm == 0){
+    proc_freepagetable(pagetable, sz);
+    return;
+  }
+
+  acquire(&vm->lock);
+  uvmunmap(pagetable, tfva, 1, 0);
+  for(n = 0; n < NPROC; n++)
+    if(TRAPFRAME_SLOT(n) == tfva)
+      vm->slots &= ~(1L << n);
+  last = (--vm->ref == 0);
+  sz = vm->sz;
+  usyscall = vm->usyscall;
+  if(last)
+    vm->usyscall = 0;
+  release(&vm->lock);
+
+  if(last){
+    uvmunmap(pagetable, TRAMPOLINE, 1, 0);
+    uvmunmap(pagetable, USYSCALL, 1, 0);
+    uvmfree(pagetable, sz);
+    kfree((void*)usyscall);
+  }
+}
+
+// 用户程序 exec() 之后换成自己的页表，旧的 (可能与线程共享) 交给这里。
+void
+proc_execpagetable(struct proc *p, pagetable_t pagetable, uint64 sz)
+{
+  pagetable_t oldpagetable = p->pagetable;
+  uint64 oldsz = p->sz, oldtfva = p->tfva;
+  struct vmspace *oldvm = p->vm;
+
+  p->pagetable = pagetable;
+  p->sz = sz;
+  p->vm = 0;
+  p->tfva = TRAPFRAME;
+  proc_putpagetable(oldpagetable, oldsz, oldvm, oldtfva);
+}
+
+// 让所有正在用户态运行 vm 的其他 hart 至少陷入内核一次。
+// uservec 切到内核页表时会 sfence.vma，于是它们 TLB 里旧的 PTE 就失效了。
+// 调用者持有 vm->lock，并且已经把要回收的 PTE 置为无效。
+static void
+tlbshootdown(struct vmspace *vm)
+{
+  struct cpu *c;
+  struct proc *cp;
+  uint64 gen[NCPU];
+  int i, need[NCPU];
+  int me = cpuid();
+
+  __sync_synchronize();
+  for(i = 0; i < NCPU; i++){
+    c = &cpus[i];
+    gen[i] = c->ugen;
+    cp = c->proc;
+    need[i] = i != me && c->inuser && cp != 0 && cp->vm == vm;
+    if(need[i])
+      *(volatile uint32*)CLINT_MSIP(i) = 1;   // 由 timervec 转成 supervisor 软中断
+  }
+
+  for(i = 0; i < NCPU; i++){
+    if(!need[i])
+      continue;
+    c = &cpus[i];
+    while(*(volatile int*)&c->inuser && *(volatile uint64*)&c->ugen == gen[i])
+      ;
+  }
+}
+
+// a user program that calls exec("/init")
+// od -t xC initcode
+uchar initcode[] = {
+  0x17, 0x05, 0x00, 0x00, 0x13, 0x05, 0x45, 0x02,
+  0x97, 0x05, 0x00, 0x00, 0x93, 0x85, 0x35, 0x02,
+  0x93, 0x08, 0x70, 0x00, 0x73, 0x00, 0x00, 0x00,
+  0x93, 0x08, 0x20, 0x00, 0x73, 0x00, 0x00, 0x00,
+  0xef, 0xf0, 0x9f, 0xff, 0x2f, 0x69, 0x6e, 0x69,
+  0x74, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00
+};
+
+// Set up first user process.
+void
+userinit(void)
+{
+  struct proc *p;
+
+  p = allocproc(0);
+  initproc = p;
+  
+  // allocate one user page and copy init's instructions
+  // and data into it.
+  uvminit(p->pagetable, initcode, sizeof(initcode));
+  p->sz = PGSIZE;
+
+  // prepare for the very first "return" from kernel to user.
+  p->trapframe->epc = 0;      // user program counter
+  p->trapframe->sp = PGSIZE;  // user stack pointer
+
+  safestrcpy(p->name, "initcode", sizeof(p->name));
+  p->cwd = namei("/");
+
+  p->state = RUNNABLE;
+
+  release(&p->lock);
+}
+
+// labx clone
+// copyin/copyout/futex 用 walkaddr 拿到物理地址以后直接读写，TLB shootdown 管不到它们。
+// 每访问一页前后调用这一对，vmgrow() 缩小时让 PTE 失效以后等 kusers 降到 0 再回收，
+// 之后进来的访问 walkaddr 会失败。
+// 中间关中断，不会被时钟中断切走，否则单核上缩小的一方会一直空等；也不能睡眠。
+// 地址空间没有共享时什么都不做，返回 0。
+struct vmspace*
+vmaccess_begin(void)
+{
+  struct proc *p = myproc();
+  struct vmspace *vm;
+
+  if(p == 0 || (vm = p->vm) == 0)
+    return 0;
+  push_off();
+  __sync_fetch_and_add(&vm->kusers, 1);
+  __sync_synchronize();
+  return vm;
+}
+
+void
+vmaccess_end(struct vmspace *vm)
+{
+  if(vm == 0)
+    return;
+  __sync_synchronize();
+  __sync_fetch_and_sub(&vm->kusers, 1);
+  pop_off();
+}
+
+// 把 vm->sz 写到使用 vm 的每个线程的 p->sz。
+// 调用者不能持有 vm->lock：freeproc()、clone() 是先拿 p->lock 再拿 vm->lock 的。
+// 每个线程在自己的 p->lock 里读 vm->sz，并发的几次更新里最后写的一定是最新值。
+static void
+vmsyncsz(struct vmspace *vm)
+{
+  struct proc *t;
+
+  for(t = proc; t < &proc[NPROC]; t++){
+    acquire(&t->lock);
+    if(t->vm == vm)
+      t->sz = *(volatile uint64*)&vm->sz;
+    release(&t->lock);
+  }
+}
+
+// growproc() 在共享地址空间上的版本，所有线程的 p->sz 一起更新。
+// 缩小时别的 hart 可能正在跑同一个页表，先让 PTE 失效、
+// 做一次 TLB shootdown，再等内核里的访问结束，最后回收物理页。
+static int
+vmgrow(struct vmspace *vm, int n)
+{
+  struct proc *p = myproc();
+  uint64 sz, newsz, npages;
+
+  acquire(&vm->lock);
+  sz = vm->sz;
+  newsz = sz + n;
+  if(n > 0){
+    if((newsz = uvmalloc(p->pagetable, sz, newsz)) == 0){
+      release(&vm->lock);
+      return -1;
+    }
+  } else if(n < 0 && PGROUNDUP(newsz) < PGROUNDUP(sz)){
+    npages = (PGROUNDUP(sz) - PGROUNDUP(newsz)) / PGSIZE;
+    uvminvalidate(p->pagetable, PGROUNDUP(newsz), npages);
+    tlbshootdown(vm);
+    __sync_synchronize();
+    while(*(volatile int*)&vm->kusers > 0)
+      ;
+    uvmreap(p->pagetable, PGROUNDUP(newsz), npages);
+  }
+  vm->sz = newsz;
+  release(&vm->lock);
+  vmsyncsz(vm);
+  return 0;
+}
+
+// Grow or shrink user memory by n bytes. Return 0 on success, -1 on failure.
+// 增加或缩小用户的内存
+int
+growproc(int n)
+{
+  uint sz;
+  struct proc *p = myproc();
+  struct vmspace *vm = p->vm;
+
+  if(vm)
+    return vmgrow(vm, n);
+
+  sz = p->sz;
+  if(n > 0){
+    if((sz = uvmalloc(p->pagetable, sz, sz + n)) == 0) {
+      return -1;
+    }
+  } else if(n < 0){
+    sz = uvmdealloc(p->pagetable, sz, sz + n);
+  }
+  p->sz = sz;
+  return 0;
+}
+
+// labx chan
+// 在用户地址空间的末尾加一页带 PTE_SHARED 的零页，返回它的用户地址，失败返回 0。
+// fork() 出来的子进程和父进程映射同一个物理页，用来在进程之间传消息。
+uint64
+chancreate(void)
+{
+  struct proc *p = myproc();
+  struct vmspace *vm = p->vm;
+  uint64 va;
+  char *mem;
+
+  if((mem = kalloc()) == 0)
+    return 0;
+  memset(mem, 0, PGSIZE);
+
+  if(vm)
+    acquire(&vm->lock);
+  va = PGROUNDUP(p->sz);
+  if(va + PGSIZE > TRAPFRAME_SLOT(NPROC) ||
+     mappages(p->pagetable, va, PGSIZE, (uint64)mem,
+              PTE_R|PTE_W|PTE_U|PTE_SHARED) != 0){
+    if(vm)
+      release(&vm->lock);
+    kfree(mem);
+    return 0;
+  }
+  if(vm){
+    vm->sz = va + PGSIZE;
+    release(&vm->lock);
+    vmsyncsz(vm);
+  } else {
+    p->sz = va + PGSIZE;
+  }
+  return va;
+}
+
+// Create a new process, copying the parent.
+// Sets up child kernel stack to return as if from fork() system call.
+int
+fork(void)
+{
+  int i, pid;
+  struct proc *np;
+  struct proc *p = myproc();
+
+  // Allocate process.
+  if((np = allocproc(0)) == 0){
+    return -1;
+  }
+
+  // Copy user memory from parent to child.
+  // 父进程的地址空间若与线程共享，拷贝期间不能让别的线程改变它的大小
+  if(p->vm)
+    acquire(&p->vm->lock);
+  if(uvmcopy(p->pagetable, np->pagetable, p->sz) < 0){
+    if(p->vm)
+      release(&p->vm->lock);
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+  np->sz = p->sz;
+  if(p->vm)
+    release(&p->vm->lock);
+
+  np->mask = p->mask; // trace 表
+  np->cpumask = p->cpumask;
+
+  // copy saved user registers.
+  *(np->trapframe) = *(p->trapframe);
+
+  // Cause fork to return 0 in the child.
+  np->trapframe->a0 = 0;
+
+  // increment reference counts on open file descriptors.
+  for(i = 0; i < NOFILE; i++)
+    if(p->ofile[i])
+      np->ofile[i] = filedup(p->ofile[i]);
+  np->cwd = idup(p->cwd);
+
+  safestrcpy(np->name, p->name, sizeof(p->name));
+
+  pid = np->pid;
+
+  release(&np->lock);
+
+  acquire(&wait_lock);
+  np->parent = p;
+  release(&wait_lock);
+
+  acquire(&np->lock);
+  np->state = RUNNABLE;
+  release(&np->lock);
+
+  return pid;
+}
+
+// labx spawn
+// fork() + exec() 合在一起：子进程拿到一个全新的页表，直接装入 path，
+// 不用先 uvmcopy() 一遍父进程的内存再扔掉，开销与父进程大小无关。
+// exec 之前按 act 依次调整子进程的文件描述符 (见 spawn.h)。
+// 成功返回子进程的 pid，失败返回 -1，子进程被直接回收。
+int
+spawn(char *path, char **argv, struct spawn_action *act, int nact)
+{
+  int i, argc, pid;
+  struct proc *np;
+  struct proc *p = myproc();
+  struct spawn_action *a;
+  struct file *f;
+
+  // Allocate process.
+  if((np = allocproc(0)) == 0){
+    return -1;
+  }
+  // 下面要读磁盘，不能拿着自旋锁；状态是 USED，调度器不会碰它
+  release(&np->lock);
+
+  np->mask = p->mask; // trace 表
+  np->cpumask = p->cpumask;
+
+  for(i = 0; i < NOFILE; i++)
+    if(p->ofile[i])
+      np->ofile[i] = filedup(p->ofile[i]);
+  np->cwd = idup(p->cwd);
+
+  for(a = act; a < &act[nact]; a++){
+    if(a->fd < 0 || a->fd >= NOFILE)
+      goto bad;
+    if(a->op == SPAWN_CLOSE){
+      if((f = np->ofile[a->fd]) != 0){
+        np->ofile[a->fd] = 0;
+        fileclose(f);
+      }
+    } else if(a->op == SPAWN_DUP2){
+      if(a->newfd < 0 || a->newfd >= NOFILE || np->ofile[a->fd] == 0)
+        goto bad;
+      if(a->newfd == a->fd)
+        continue;
+      if((f = np->ofile[a->newfd]) != 0)
+        fileclose(f);
+      np->ofile[a->newfd] = filedup(np->ofile[a->fd]);
+    } else {
+      goto bad;
+    }
+  }
+
+  if((argc = execproc(np, path, argv)) < 0)
+    goto bad;
+  np->trapframe->a0 = argc;
+
+  pid = np->pid;
+
+  acquire(&wait_lock);
+  np->parent = p;
+  release(&wait_lock);
+
+  acquire(&np->lock);
+  np->state = RUNNABLE;
+  release(&np->lock);
+
+  return pid;
+
+bad:
+  for(i = 0; i < NOFILE; i++){
+    if((f = np->ofile[i]) != 0){
+      np->ofile[i] = 0;
+      fileclose(f);
+    }
+  }
+  begin_op();
+  iput(np->cwd);
+  end_op();
+  np->cwd = 0;
+
+  acquire(&np->lock);
+  freeproc(np);
+  release(&np->lock);
+  return -1;
+}
+
+// Pass p's abandoned children to init.
+// Caller must hold wait_lock.
+void
+reparent(struct proc *p)
+{
+  struct proc *pp;
+
+  for(pp = proc; pp < &proc[NPROC]; pp++){
+    if(pp->parent == p){
+      pp->parent = initproc;
+      wakeup(initproc);
+    }
+  }
+}
+
+// Exit the current process.  Does not return.
+// An exited process remains in the zombie state
+// until its parent calls wait().
+void
+exit(int status)
+{
+  struct proc *p = myproc();
+
+  if(p == initproc)
+    panic("init exiting");
+
+  // Close all open files.
+  for(int fd = 0; fd < NOFILE; fd++){
+    if(p->ofile[fd]){
+      struct file *f = p->ofile[fd];
+      fileclose(f);
+      p->ofile[fd] = 0;
+    }
+  }
+
+  begin_op();
+  iput(p->cwd);
+  end_op();
+  p->cwd = 0;
+
+  acquire(&wait_lock);
+
+  // Give any children to init.
+  reparent(p);
+
+  // Parent might be sleeping in wait().
+  wakeup(p->parent);
+  
+  acquire(&p->lock);
+
+  p->xstate = status;
+  p->state = ZOMBIE;
+
+  release(&wait_lock);
+
+  // Jump into the scheduler, never to return.
+  sched();
+  panic("zombie exit");
+}
+
+// labx clone
+// np 是不是 p 用 clone() 创建、仍与 p 共享地址空间的线程
+static int
+isthread(struct proc *p, struct proc *np)
+{
+  return np->vm != 0 && np->vm == p->vm;
+}
+
+// wait() 和 join() 的公共部分：threads 为 0 时等待普通子进程，
+// 把退出状态写到 addr；否则等待子线程，把它的栈地址写到 addr。
+static int
+waitchild(uint64 addr, int threads)
+{
+  struct proc *np;
+  int havekids, pid;
+  struct proc *p = myproc();
+  void *src;
+  int n;
+
+  acquire(&wait_lock);
+
+  for(;;){
+    // Scan through table looking for exited children.
+    havekids = 0;
+    for(np = proc; np < &proc[NPROC]; np++){
+      if(np->parent == p && isthread(p, np) == threads){
+        // make sure the child isn't still in exit() or swtch().
+        acquire(&np->lock);
+
+        havekids = 1;
+        if(np->state == ZOMBIE){
+          // Found one.
+          pid = np->pid;
+          if(threads){
+            src = &np->ustack;
+            n = sizeof(np->ustack);
+          } else {
+            src = &np->xstate;
+            n = sizeof(np->xstate);
+          }
+          if(addr != 0 && copyout(p->pagetable, addr, src, n) < 0) {
+            release(&np->lock);
+            release(&wait_lock);
+            return -1;
+          }
+          freeproc(np);
+          release(&np->lock);
+          release(&wait_lock);
+          return pid;
+        }
+        release(&np->lock);
+      }
+    }
+
+    // No point waiting if we don't have any children.
+    if(!havekids || p->killed){
+      release(&wait_lock);
+      return -1;
+    }
+    
+    // Wait for a child to exit.
+    sleep(p, &wait_lock);  //DOC: wait-sleep
+  }
+}
+
+// Wait for a child process to exit and return its pid.
+// Return -1 if this process has no children.
+// 与自己共享地址空间的线程要用 join() 回收
+int
+wait(uint64 addr)
+{
+  return waitchild(addr, 0);
+}
+
+// labx join
+// 等待一个子线程退出并回收它，返回它的 pid，
+// clone() 时的栈地址写到用户地址 addr。
+int
+join(uint64 addr)
+{
+  return waitchild(addr, 1);
+}
+
+// labx clone
+// 创建一个与当前进程共享页表的线程：
+// 打开的文件和 cwd 与 fork() 一样引用同一份，
+// 自己有独立的内核栈和 trapframe (映射在 TRAPFRAME_SLOT(n))，
+// 从 fn(arg) 开始执行，用 [stack, stack+PGSIZE) 这一页作为用户栈。
+int
+clone(uint64 fn, uint64 stack, uint64 arg)
+{
+  int i, pid, slot;
+  struct proc *np;
+  struct proc *p = myproc();
+  struct vmspace *vm;
+
+  if(stack % 16 != 0 || stack + PGSIZE < stack || stack + PGSIZE > p->sz)
+    return -1;
+
+  if((np = allocproc(1)) == 0){
+    return -1;
+  }
+
+  if((vm = vmspace_get(p)) == 0){
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+
+  // 找一个空闲的 trapframe 槽位并映射进共享的页表
+  for(slot = 0; slot < NPROC; slot++)
+    if((vm->slots & (1L << slot)) == 0)
+      break;
+  if(slot == NPROC ||
+     mappages(p->pagetable, TRAPFRAME_SLOT(slot), PGSIZE,
+              (uint64)(np->trapframe), PTE_R | PTE_W) < 0){
+    release(&vm->lock);
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+  vm->slots |= 1L << slot;
+  vm->ref++;
+  np->pagetable = p->pagetable;
+  np->sz = vm->sz;
+  np->vm = vm;
+  np->tfva = TRAPFRAME_SLOT(slot);
+  release(&vm->lock);
+
+  // 新线程从 fn(arg) 开始，栈顶在 stack 这一页的末尾
+  *(np->trapframe) = *(p->trapframe);
+  np->trapframe->epc = fn;
+  np->trapframe->sp = stack + PGSIZE;
+  np->trapframe->a0 = arg;
+  np->ustack = stack;
+
+  np->mask = p->mask;
+  np->cpumask = p->cpumask;
+
+  for(i = 0; i < NOFILE; i++)
+    if(p->ofile[i])
+      np->ofile[i] = filedup(p->ofile[i]);
+  np->cwd = idup(p->cwd);
+
+  safestrcpy(np->name, p->name, sizeof(p->name));
+
+  pid = np->pid;
+
+  release(&np->lock);
+
+  acquire(&wait_lock);
+  np->parent = p;
+  release(&wait_lock);
+
+  acquire(&np->lock);
+  np->state = RUNNABLE;
+  release(&np->lock);
+
+  return pid;
+}
+
+// Per-CPU process scheduler.
+// Each CPU calls scheduler() after setting itself up.
+// Scheduler never returns.  It loops, doing:
+//  - choose a process to run.
+//  - swtch to start running that process.
+//  - eventually that process transfers control
+//    via swtch back to the scheduler.
+void
+scheduler(void)
+{
+  struct proc *p;
+  struct cpu *c = mycpu();
+  
+  c->proc = 0;
+  for(;;){
+    // Avoid deadlock by ensuring that devices can interrupt.
+    intr_on();
+
+    for(p = proc; p < &proc[NPROC]; p++) {
+      acquire(&p->lock);
+      // labx setaffinity: 跳过不允许在这个 CPU 上运行的进程
+      if(p->state == RUNNABLE && (p->cpumask == 0 || (p->cpumask >> cpuid()) & 1)) {
+        // Switch to chosen process.  It is the process's job
+        // to release its lock and then reacquire it
+        // before jumping back to us.
+        p->state = RUNNING;
+        c->proc = p;
+        swtch(&c->context, &p->context);
+
+        // Process is done running for now.
+        // It should have changed its p->state before coming back.
+        c->proc = 0;
+      }
+      release(&p->lock);
+    }
+  }
+}
+
+// Switch to scheduler.  Must hold only p->lock
+// and have changed proc->state. Saves and restores
+// intena because intena is a property of this
+// kernel thread, not this CPU. It should
+// be proc->intena and proc->noff, but that would
+// break in the few places where a lock is held but
+// there's no process.
+void
+sched(void)
+{
+  int intena;
+  struct proc *p = myproc();
+
+  if(!holding(&p->lock))
+    panic("sched p->lock");
+  if(mycpu()->noff != 1)
+    panic("sched locks");
+  if(p->state == RUNNING)
+    panic("sched running");
+  if(intr_get())
+    panic("sched interruptible");
+
+  intena = mycpu()->intena;
+  swtch(&p->context, &mycpu()->context);
+  mycpu()->intena = intena;
+}
+
+// Give up the CPU for one scheduling round.
+void
+yield(void)
+{
+  struct proc *p = myproc();
+  acquire(&p->lock);
+  p->state = RUNNABLE;
+  sched();
+  release(&p->lock);
+}
+
+// A fork child's very first scheduling by scheduler()
+// will swtch to forkret.
+void
+forkret(void)
+{
+  static int first = 1;
+
+  // Still holding p->lock from scheduler.
+  release(&myproc()->lock);
+
+  if (first) {
+    // File system initialization must be run in the context of a
+    // regular process (e.g., because it calls sleep), and thus cannot
+    // be run from main().
+    first = 0;
+    fsinit(ROOTDEV);
+  }
+
+  usertrapret();
+}
+
+// Atomically release lock and sleep on chan.
+// Reacquires lock when awakened.
+void
+sleep(void *chan, struct spinlock *lk)
+{
+  struct proc *p = myproc();
+  
+  // Must acquire p->lock in order to
+  // change p->state and then call sched.
+  // Once we hold p->lock, we can be
+  // guaranteed that we won't miss any wakeup
+  // (wakeup locks p->lock),
+  // so it's okay to release lk.
+
+  acquire(&p->lock);  //DOC: sleeplock1
+  release(lk);
+
+  // Go to sleep.
+  p->chan = chan;
+  p->state = SLEEPING;
+
+  sched();
+
+  // Tidy up.
+  p->chan = 0;
+
+  // Reacquire original lock.
+  release(&p->lock);
+  acquire(lk);
+}
+
+// Wake up all processes sleeping on chan.
+// Must be called without any p->lock.
+void
+wakeup(void *chan)
+{
+  struct proc *p;
+
+  for(p = proc; p < &proc[NPROC]; p++) {
+    if(p != myproc()){
+      acquire(&p->lock);
+      if(p->state == SLEEPING && p->chan == chan) {
+        p->state = RUNNABLE;
+      }
+      release(&p->lock);
+    }
+  }
+}
+
+// Kill the process with the given pid.
+// The victim won't exit until it tries to return
+// to user space (see usertrap() in trap.c).
+int
+kill(int pid)
+{
+  struct proc *p;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid){
+      p->killed = 1;
+      if(p->state == SLEEPING){
+        // Wake process from sleep().
+        p->state = RUNNABLE;
+      }
+      release(&p->lock);
+      return 0;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
+// Copy to either a user address, or kernel address,
+// depending on usr_dst.
+// Returns 0 on success, -1 on error.
+int
+either_copyout(int user_dst, uint64 dst, void *src, uint64 len)
+{
+  struct proc *p = myproc();
+  if(user_dst){
+    return copyout(p->pagetable, dst, src, len);
+  } else {
+    memmove((char *)dst, src, len);
+    return 0;
+  }
+}
+
+// Copy from either a user address, or kernel address,
+// depending on usr_src.
+// Returns 0 on success, -1 on error.
+int
+either_copyin(void *dst, int user_src, uint64 src, uint64 len)
+{
+  struct proc *p = myproc();
+  if(user_src){
+    return copyin(p->pagetable, dst, src, len);
+  } else {
+    memmove(dst, (char*)src, len);
+    return 0;
+  }
+}
+
+// Print a process listing to console.  For debugging.
+// Runs when user types ^P on console.
+// No lock to avoid wedging a stuck machine further.
+void
+procdump(void)
+{
+  static char *states[] = {
+  [UNUSED]    "unused",
+  [SLEEPING]  "sleep ",
+  [RUNNABLE]  "runble",
+  [RUNNING]   "run   ",
+  [ZOMBIE]    "zombie"
+  };
+  struct proc *p;
+  char *state;
+
+  printf("\n");
+  for(p = proc; p < &proc[NPROC]; p++){
+    if(p->state == UNUSED)
+      continue;
+    if(p->state >= 0 && p->state < NELEM(states) && states[p->state])
+      state = states[p->state];
+    else
+      state = "???";
+    printf("%d %s %s", p->pid, state, p->name);
+    printf("\n");
+  }
+}
+
+// lab 3 - page table
+int pgaccess(void* starting_va, int num, void* ans_buff)
+{
+  if (num <= 0) {
+    return -1;
+  }
+
+  // 获取当前进程的页表
+  pagetable_t pagetable = myproc()->pagetable;
+
+  uint64 mask;
+  for (int i = 0; i < num; ++ i) {
+    // vmprint(pagetable);
+    pte_t* pte;
+    pte = walk(pagetable, ((uint64)starting_va + (uint64)(PGSIZE) * i), 0);
+    
+    // 被访问过
+    if (*pte && (*pte & PTE_A)) {
+      mask |= 1 << i;
+      *pte ^= PTE_A;  // 清除 pte 的 PTE_A 属性
+    }
+  }
+  
+  copyout(pagetable, (uint64)ans_buff, (char*)&mask, sizeof(mask));
+  return 0;
+}
+
+// lab2 sysinfo -> count not free process
+// whose state is not UNUSED
+uint64
+sysinfo_free_proc()
+{
+  uint64 free_proc = 0;
+  // struct proc proc[NPROC];   保存了所有的进程
+  for (struct proc *p = proc; p < &proc[NPROC]; ++ p) {
+    acquire(&p->lock);  // 上锁
+    if (p->state != UNUSED) {   // whose state is not UNUSED !!!!!!!!
+      ++ free_proc;
+    }
+    release(&p->lock);  // 解锁
+  }
+  return free_proc;
+}
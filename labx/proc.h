@@ -0,0 +1,136 @@
+// 上下文切换的时候保存内存信息到这些寄存器: ra, sp, s0~s11
+// Saved registers for kernel context switches.
+struct context {
+  uint64 ra;
+  uint64 sp;
+
+  // callee-saved
+  uint64 s0;
+  uint64 s1;
+  uint64 s2;
+  uint64 s3;
+  uint64 s4;
+  uint64 s5;
+  uint64 s6;
+  uint64 s7;
+  uint64 s8;
+  uint64 s9;
+  uint64 s10;
+  uint64 s11;
+};
+
+// Per-CPU state.
+struct cpu {
+  struct proc *proc;          // The process running on this cpu, or null.
+  struct context context;     // swtch() here to enter scheduler().
+  int noff;                   // Depth of push_off() nesting.
+  int intena;                 // Were interrupts enabled before push_off()?
+  int inuser;                 // 是否正在用户态运行，TLB shootdown 用
+  uint64 ugen;                // 每次从用户态陷入内核时加一
+};
+
+extern struct cpu cpus[NCPU];
+
+// per-process data for the trap handling code in trampoline.S.
+// sits in a page by itself just under the trampoline page in the
+// user page table. not specially mapped in the kernel page table.
+// the sscratch register points here.
+// uservec in trampoline.S saves user registers in the trapframe,
+// then initializes registers from the trapframe's
+// kernel_sp, kernel_hartid, kernel_satp, and jumps to kernel_trap.
+// usertrapret() and userret in trampoline.S set up
+// the trapframe's kernel_*, restore user registers from the
+// trapframe, switch to the user page table, and enter user space.
+// the trapframe includes callee-saved user registers like s0-s11 because the
+// return-to-user path via usertrapret() doesn't return through
+// the entire kernel call stack.
+struct trapframe {
+  /*   0 */ uint64 kernel_satp;   // kernel page table
+  /*   8 */ uint64 kernel_sp;     // top of process's kernel stack
+  /*  16 */ uint64 kernel_trap;   // usertrap()
+  /*  24 */ uint64 epc;           // saved user program counter
+  /*  32 */ uint64 kernel_hartid; // saved kernel tp
+  /*  40 */ uint64 ra;
+  /*  48 */ uint64 sp;
+  /*  56 */ uint64 gp;
+  /*  64 */ uint64 tp;
+  /*  72 */ uint64 t0;
+  /*  80 */ uint64 t1;
+  /*  88 */ uint64 t2;
+  /*  96 */ uint64 s0;
+  /* 104 */ uint64 s1;
+  /* 112 */ uint64 a0;
+  /* 120 */ uint64 a1;
+  /* 128 */ uint64 a2;
+  /* 136 */ uint64 a3;
+  /* 144 */ uint64 a4;
+  /* 152 */ uint64 a5;
+  /* 160 */ uint64 a6;
+  /* 168 */ uint64 a7;
+  /* 176 */ uint64 s2;
+  /* 184 */ uint64 s3;
+  /* 192 */ uint64 s4;
+  /* 200 */ uint64 s5;
+  /* 208 */ uint64 s6;
+  /* 216 */ uint64 s7;
+  /* 224 */ uint64 s8;
+  /* 232 */ uint64 s9;
+  /* 240 */ uint64 s10;
+  /* 248 */ uint64 s11;
+  /* 256 */ uint64 t3;
+  /* 264 */ uint64 t4;
+  /* 272 */ uint64 t5;
+  /* 280 */ uint64 t6;
+};
+
+// labx clone
+// clone() 出来的线程和创建者共享同一个页表，这个结构记录共享的状态。
+// 只有真正被共享的地址空间才会分配 vmspace，普通进程的 p->vm 为 0。
+struct vmspace {
+  struct spinlock lock;
+  int ref;                     // 使用这个地址空间的进程 (线程) 数
+  uint64 slots;                // 已占用的 trapframe 槽位, bit n -> TRAPFRAME_SLOT(n)
+  uint64 sz;                   // 共享的用户内存大小，各线程的 p->sz 与它保持一致
+  struct usyscall *usyscall;   // 地址空间共有的 USYSCALL 页，所以线程里 ugetpid() 返回的是创建者的 pid
+  int kusers;                  // 正在内核里按物理地址读写这块用户内存的线程数，见 vmaccess_begin()
+};
+
+// 进程状态 0 ~ 5
+enum procstate { UNUSED, USED, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
+
+// Per-process state
+// 进程信息表
+struct proc {
+  // 自旋锁
+  struct spinlock lock;
+
+  // 访问这些的时候必须上锁
+  // p->lock must be held when using these:
+
+  // 进程目前状态 定义在上面的一个 union 
+  enum procstate state;        // Process state 
+  void *chan;                  // If non-zero, sleeping on chan
+  int killed;                  // If non-zero, have been killed
+  int xstate;                  // Exit status to be returned to parent's wait
+  int pid;                     // Process ID
+  int mask;                    // trace mask
+  int cpumask;                 // labx 允许运行的 CPU，第 i 位对应 hart i，0 表示都可以
+
+  // wait_lock must be held when using this:
+  struct proc *parent;         // Parent process
+
+  // 这是一个进程私有的东西，不用上锁
+  // these are private to the process, so p->lock need not be held.
+  uint64 kstack;               // Virtual address of kernel stack
+  uint64 sz;                   // Size of process memory (bytes)
+  pagetable_t pagetable;       // User page table
+  struct trapframe *trapframe; // data page for trampoline.S
+  uint64 tfva;                 // trapframe 在用户页表中的虚拟地址
+  struct vmspace *vm;          // 与线程共享的地址空间，未共享时为 0
+  uint64 ustack;               // clone() 时传入的线程栈，join() 返回给用户
+  struct usyscall *mypid;      // lab3 USYSCALL 页
+  struct context context;      // swtch() here to run process
+  struct file *ofile[NOFILE];  // Open files
+  struct inode *cwd;           // Current directory
+  char name[16];               // Process name (debugging)
+};
@@ -0,0 +1,97 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+#include "user/user.h"
+
+// labx readahead: 顺序读一个大文件的吞吐量
+// 先写一个 nblk 块的文件，再用不同大小的 read 从头读到尾。
+// 文件比 buffer cache 大得多，每一遍都是冷的，
+// 读的速度取决于预读能不能让磁盘请求和 readi 重叠。
+
+#define MAXBUF  (16*BSIZE)
+#define NROUND  3
+
+char *file = "rbfile";
+char buf[MAXBUF];
+
+void
+mkfile(int nblk)
+{
+  int fd, i;
+
+  if((fd = open(file, O_CREATE|O_TRUNC|O_WRONLY)) < 0){
+    printf("readbench: create %s failed\n", file);
+    exit(1);
+  }
+  for(i = 0; i < nblk; i++){
+    memset(buf, i, BSIZE);
+    if(write(fd, buf, BSIZE) != BSIZE){
+      printf("readbench: write failed at block %d (disk full?)\n", i);
+      unlink(file);
+      exit(1);
+    }
+  }
+  close(fd);
+}
+
+// 用 size 字节的 read 读完整个文件，返回用的时间
+uint64
+readall(int nblk, int size)
+{
+  int fd, n, tot;
+  uint64 t0;
+
+  if((fd = open(file, O_RDONLY)) < 0){
+    printf("readbench: open %s failed\n", file);
+    exit(1);
+  }
+  t0 = rdtime();
+  tot = 0;
+  while((n = read(fd, buf, size)) > 0){
+    if((uchar)buf[0] != (uchar)(tot / BSIZE)){
+      printf("readbench: bad data at offset %d\n", tot);
+      exit(1);
+    }
+    tot += n;
+  }
+  t0 = rdtime() - t0;
+  close(fd);
+  if(tot != nblk * BSIZE){
+    printf("readbench: read %d bytes instead of %d\n", tot, nblk * BSIZE);
+    exit(1);
+  }
+  return t0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int sizes[] = { 512, BSIZE, 4*BSIZE, 16*BSIZE };
+  int nblk, i, r;
+  uint64 t, best;
+
+  nblk = 200;
+  if(argc > 1)
+    nblk = atoi(argv[1]);
+  if(argc > 2 || nblk <= 0 || nblk > MAXFILE){
+    fprintf(2, "usage: readbench [nblocks(1-%d)]\n", MAXFILE);
+    exit(1);
+  }
+
+  mkfile(nblk);
+  printf("readbench: %d KB file, best of %d rounds\n", nblk * BSIZE / 1024, NROUND);
+  for(i = 0; i < sizeof(sizes)/sizeof(sizes[0]); i++){
+    best = 0;
+    for(r = 0; r < NROUND; r++){
+      t = readall(nblk, sizes[i]);
+      if(best == 0 || t < best)
+        best = t;
+    }
+    printf("  read(%d)\t%l us\t%l KB/s\t%l us/block\n", sizes[i],
+           best * 1000000 / TIMEHZ, (uint64)nblk * BSIZE * TIMEHZ / 1024 / (best + 1),
+           best * 1000000 / TIMEHZ / nblk);
+  }
+  unlink(file);
+  exit(0);
+}
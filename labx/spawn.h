@@ -0,0 +1,12 @@
+// labx spawn
+// spawn() 在 exec 之前对子进程的文件描述符依次做的动作
+
+#define SPAWN_CLOSE   1     // close(fd)
+#define SPAWN_DUP2    2     // 关掉 newfd，再把 fd 复制到 newfd
+#define SPAWN_MAXACT  16    // 一次 spawn 最多的动作数
+
+struct spawn_action {
+  int op;                   // SPAWN_CLOSE 或 SPAWN_DUP2
+  int fd;
+  int newfd;
+};
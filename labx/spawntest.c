@@ -0,0 +1,112 @@
+#include "kernel/types.h"
+#include "kernel/riscv.h"
+#include "kernel/spawn.h"
+#include "user/user.h"
+
+// labx spawn: spawn() 的测试，以及大进程里 spawn 和 fork + exec 的对比
+
+#define NSPAWN 20
+#define BIG (4*1024*1024)
+
+// 子进程的 stdout 重定向到 pipe
+void
+testdup2()
+{
+  int fds[2], n, status;
+  char buf[16];
+  char *argv[] = { "echo", "hello", 0 };
+  struct spawn_action act[] = {
+    { SPAWN_DUP2, 0, 1 },
+    { SPAWN_CLOSE, 0, 0 },
+    { SPAWN_CLOSE, 0, 0 },
+  };
+
+  if(pipe(fds) < 0){
+    printf("spawntest: pipe failed\n");
+    exit(1);
+  }
+  act[0].fd = fds[1];
+  act[1].fd = fds[0];
+  act[2].fd = fds[1];
+  if(spawn("echo", argv, act, 3) < 0){
+    printf("spawntest: FAIL spawn echo\n");
+    exit(1);
+  }
+  close(fds[1]);
+  n = read(fds[0], buf, sizeof(buf));
+  close(fds[0]);
+  wait(&status);
+  if(n != 6 || memcmp(buf, "hello\n", 6) != 0 || status != 0){
+    printf("spawntest: FAIL echo output\n");
+    exit(1);
+  }
+}
+
+// exec 失败不能留下子进程
+void
+testbad()
+{
+  char *argv[] = { "nosuchfile", 0 };
+  struct spawn_action act[] = { { 99, 0, 0 } };
+
+  if(spawn("nosuchfile", argv, 0, 0) != -1){
+    printf("spawntest: FAIL spawn nosuchfile\n");
+    exit(1);
+  }
+  if(spawn("echo", argv, act, 1) != -1){
+    printf("spawntest: FAIL bad action\n");
+    exit(1);
+  }
+  if(wait(0) != -1){
+    printf("spawntest: FAIL child left behind\n");
+    exit(1);
+  }
+}
+
+// 父进程有 BIG 字节内存时，spawn 与 fork + exec 各跑 NSPAWN 次
+void
+bench()
+{
+  int i, t0, t1, pid;
+  char *argv[] = { "echo", 0 };
+  struct spawn_action act[] = { { SPAWN_CLOSE, 1, 0 } };
+
+  if(sbrk(BIG) == (char*)-1){
+    printf("spawntest: sbrk failed\n");
+    exit(1);
+  }
+
+  t0 = uptime();
+  for(i = 0; i < NSPAWN; i++){
+    if((pid = fork()) == 0){
+      close(1);
+      exec("echo", argv);
+      exit(1);
+    }
+    wait(0);
+  }
+  t1 = uptime();
+  printf("spawntest: %d fork+exec from a %d byte parent: %d ticks\n", NSPAWN, BIG, t1 - t0);
+
+  t0 = uptime();
+  for(i = 0; i < NSPAWN; i++){
+    if(spawn("echo", argv, act, 1) < 0){
+      printf("spawntest: spawn failed\n");
+      exit(1);
+    }
+    wait(0);
+  }
+  t1 = uptime();
+  printf("spawntest: %d spawn from a %d byte parent: %d ticks\n", NSPAWN, BIG, t1 - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  printf("spawntest: start\n");
+  testdup2();
+  testbad();
+  bench();
+  printf("spawntest: OK\n");
+  exit(0);
+}
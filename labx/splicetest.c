@@ -0,0 +1,115 @@
+#include "kernel/types.h"
+#include "kernel/fcntl.h"
+#include "user/user.h"
+
+// labx splice: 文件 -> pipe -> 文件，以及和 read/write 搬运的对比
+
+#define FSZ (64*1024)
+
+char buf[4096];
+
+void
+mkfile(char *name)
+{
+  int fd, i;
+
+  if((fd = open(name, O_CREATE|O_RDWR|O_TRUNC)) < 0){
+    printf("splicetest: create %s failed\n", name);
+    exit(1);
+  }
+  for(i = 0; i < FSZ; i += sizeof(buf)){
+    memset(buf, 'a' + (i / sizeof(buf)) % 26, sizeof(buf));
+    if(write(fd, buf, sizeof(buf)) != sizeof(buf)){
+      printf("splicetest: write failed\n");
+      exit(1);
+    }
+  }
+  close(fd);
+}
+
+// 子进程把 src 灌进 pipe，父进程从 pipe 搬到 dst；usesplice 为 0 时用 read/write
+int
+copy(char *src, char *dst, int usesplice)
+{
+  int fds[2], in, out, n, total, t0;
+
+  t0 = uptime();
+  if(pipe2(fds, 16384) < 0){
+    printf("splicetest: pipe2 failed\n");
+    exit(1);
+  }
+  if(fork() == 0){
+    close(fds[0]);
+    in = open(src, O_RDONLY);
+    if(usesplice){
+      while((n = splice(in, fds[1], FSZ)) > 0)
+        ;
+    } else {
+      while((n = read(in, buf, sizeof(buf))) > 0)
+        write(fds[1], buf, n);
+    }
+    exit(n < 0);
+  }
+  close(fds[1]);
+  out = open(dst, O_CREATE|O_WRONLY|O_TRUNC);
+  total = 0;
+  if(usesplice){
+    while((n = splice(fds[0], out, FSZ)) > 0)
+      total += n;
+  } else {
+    while((n = read(fds[0], buf, sizeof(buf))) > 0)
+      total += write(out, buf, n);
+  }
+  close(fds[0]);
+  close(out);
+  wait(0);
+  if(total != FSZ){
+    printf("splicetest: FAIL copied %d bytes instead of %d\n", total, FSZ);
+    exit(1);
+  }
+  return uptime() - t0;
+}
+
+void
+check(char *a, char *b)
+{
+  static char buf2[sizeof(buf)];
+  int fa, fb, n;
+
+  fa = open(a, O_RDONLY);
+  fb = open(b, O_RDONLY);
+  while((n = read(fa, buf, sizeof(buf))) > 0){
+    if(read(fb, buf2, n) != n || memcmp(buf, buf2, n) != 0){
+      printf("splicetest: FAIL %s and %s differ\n", a, b);
+      exit(1);
+    }
+  }
+  close(fa);
+  close(fb);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fds[2], t;
+
+  printf("splicetest: start\n");
+  if(pipe(fds) < 0 || splice(fds[0], fds[1], 1) != -1){
+    printf("splicetest: FAIL splice a pipe into itself\n");
+    exit(1);
+  }
+  close(fds[0]);
+  close(fds[1]);
+
+  mkfile("splice.in");
+  t = copy("splice.in", "splice.rw", 0);
+  printf("splicetest: read/write %d bytes: %d ticks\n", FSZ, t);
+  t = copy("splice.in", "splice.out", 1);
+  printf("splicetest: splice %d bytes: %d ticks\n", FSZ, t);
+  check("splice.in", "splice.out");
+  unlink("splice.in");
+  unlink("splice.rw");
+  unlink("splice.out");
+  printf("splicetest: OK\n");
+  exit(0);
+}
@@ -0,0 +1,42 @@
+// System call numbers
+#define SYS_fork    1
+#define SYS_exit    2
+#define SYS_wait    3
+#define SYS_pipe    4
+#define SYS_read    5
+#define SYS_kill    6
+#define SYS_exec    7
+#define SYS_fstat   8
+#define SYS_chdir   9
+#define SYS_dup    10
+#define SYS_getpid 11
+#define SYS_sbrk   12
+#define SYS_sleep  13
+#define SYS_uptime 14
+#define SYS_open   15
+#define SYS_write  16
+#define SYS_mknod  17
+#define SYS_unlink 18
+#define SYS_link   19
+#define SYS_mkdir  20
+#define SYS_close  21
+#define SYS_trace  22
+#define SYS_sysinfo   23
+#define SYS_pgaccess  24
+#define SYS_clone  25
+#define SYS_join   26
+#define SYS_futex_wait 27
+#define SYS_futex_wake 28
+#define SYS_spawn  29
+#define SYS_pipe2  30
+#define SYS_splice 31
+#define SYS_chan_create 32
+#define SYS_readv  33
+#define SYS_writev 34
+#define SYS_poll   35
+#define SYS_eventfd 36
+#define SYS_getdents 37
+#define SYS_setaffinity 38
+#define SYS_iostat 39
+#define SYS_hmkdir 40
+#define SYS_dcstat 41
@@ -0,0 +1,741 @@
+//
+// File-system system calls.
+// Mostly argument checking, since we don't trust
+// user code, and calls into file.c and fs.c.
+//
+
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "stat.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "fcntl.h"
+#include "spawn.h"
+#include "uio.h"
+#include "iostat.h"
+#include "dcache.h"
+
+// Fetch the nth word-sized system call argument as a file descriptor
+// and return both the descriptor and the corresponding struct file.
+static int
+argfd(int n, int *pfd, struct file **pf)
+{
+  int fd;
+  struct file *f;
+
+  if(argint(n, &fd) < 0)
+    return -1;
+  if(fd < 0 || fd >= NOFILE || (f=myproc()->ofile[fd]) == 0)
+    return -1;
+  if(pfd)
+    *pfd = fd;
+  if(pf)
+    *pf = f;
+  return 0;
+}
+
+// Allocate a file descriptor for the given file.
+// Takes over file reference from caller on success.
+static int
+fdalloc(struct file *f)
+{
+  int fd;
+  struct proc *p = myproc();
+
+  for(fd = 0; fd < NOFILE; fd++){
+    if(p->ofile[fd] == 0){
+      p->ofile[fd] = f;
+      return fd;
+    }
+  }
+  return -1;
+}
+
+uint64
+sys_dup(void)
+{
+  struct file *f;
+  int fd;
+
+  if(argfd(0, 0, &f) < 0)
+    return -1;
+  if((fd=fdalloc(f)) < 0)
+    return -1;
+  filedup(f);
+  return fd;
+}
+
+uint64
+sys_read(void)
+{
+  struct file *f;
+  int n;
+  uint64 p;
+
+  if(argfd(0, 0, &f) < 0 || argint(2, &n) < 0 || argaddr(1, &p) < 0)
+    return -1;
+  return fileread(f, p, n);
+}
+
+uint64
+sys_write(void)
+{
+  struct file *f;
+  int n;
+  uint64 p;
+
+  if(argfd(0, 0, &f) < 0 || argint(2, &n) < 0 || argaddr(1, &p) < 0)
+    return -1;
+
+  return filewrite(f, p, n);
+}
+
+uint64
+sys_close(void)
+{
+  int fd;
+  struct file *f;
+
+  if(argfd(0, &fd, &f) < 0)
+    return -1;
+  myproc()->ofile[fd] = 0;
+  fileclose(f);
+  return 0;
+}
+
+uint64
+sys_fstat(void)
+{
+  struct file *f;
+  uint64 st; // user pointer to struct stat
+
+  if(argfd(0, 0, &f) < 0 || argaddr(1, &st) < 0)
+    return -1;
+  return filestat(f, st);
+}
+
+// Create the path new as a link to the same inode as old.
+uint64
+sys_link(void)
+{
+  char name[DIRSIZ], new[MAXPATH], old[MAXPATH];
+  struct inode *dp, *ip;
+
+  if(argstr(0, old, MAXPATH) < 0 || argstr(1, new, MAXPATH) < 0)
+    return -1;
+
+  begin_opn(DIROPBLOCKS);
+  if((ip = namei(old)) == 0){
+    end_opn(DIROPBLOCKS);
+    return -1;
+  }
+
+  ilock(ip);
+  if(ip->type == T_DIR){
+    iunlockput(ip);
+    end_opn(DIROPBLOCKS);
+    return -1;
+  }
+
+  ip->nlink++;
+  iupdate(ip);
+  iunlock(ip);
+
+  if((dp = nameiparent(new, name)) == 0)
+    goto bad;
+  ilock(dp);
+  if(dp->dev != ip->dev || dirlink(dp, name, ip->inum) < 0){
+    iunlockput(dp);
+    goto bad;
+  }
+  iunlockput(dp);
+  iput(ip);
+
+  end_opn(DIROPBLOCKS);
+
+  return 0;
+
+bad:
+  ilock(ip);
+  ip->nlink--;
+  iupdate(ip);
+  iunlockput(ip);
+  end_opn(DIROPBLOCKS);
+  return -1;
+}
+
+// Is the directory dp empty except for "." and ".." ?
+static int
+isdirempty(struct inode *dp)
+{
+  int off;
+  struct dirent de;
+
+  // labx hashed directory: 散列目录里 . 和 .. 不一定在最前面
+  for(off=0; off<dp->size; off+=sizeof(de)){
+    if(readi(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
+      panic("isdirempty: readi");
+    if(de.inum != 0 && namecmp(de.name, ".") != 0 && namecmp(de.name, "..") != 0)
+      return 0;
+  }
+  return 1;
+}
+
+uint64
+sys_unlink(void)
+{
+  struct inode *ip, *dp;
+  struct dirent de;
+  char name[DIRSIZ], path[MAXPATH];
+  uint off;
+
+  if(argstr(0, path, MAXPATH) < 0)
+    return -1;
+
+  begin_op();
+  if((dp = nameiparent(path, name)) == 0){
+    end_op();
+    return -1;
+  }
+
+  ilock(dp);
+
+  // Cannot unlink "." or "..".
+  if(namecmp(name, ".") == 0 || namecmp(name, "..") == 0)
+    goto bad;
+
+  if((ip = dirlookup(dp, name, &off)) == 0)
+    goto bad;
+  ilock(ip);
+
+  if(ip->nlink < 1)
+    panic("unlink: nlink < 1");
+  if(ip->type == T_DIR && !isdirempty(ip)){
+    iunlockput(ip);
+    goto bad;
+  }
+
+  memset(&de, 0, sizeof(de));
+  if(writei(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
+    panic("unlink: writei");
+  dcenter(dp->dev, dp->inum, name, 0, 0);   // labx dcache: 记成不存在
+  if(ip->type == T_DIR){
+    dp->nlink--;
+    iupdate(dp);
+  }
+  iunlockput(dp);
+
+  ip->nlink--;
+  iupdate(ip);
+  iunlockput(ip);
+
+  end_op();
+
+  return 0;
+
+bad:
+  iunlockput(dp);
+  end_op();
+  return -1;
+}
+
+static struct inode*
+create(char *path, short type, short major, short minor)
+{
+  struct inode *ip, *dp;
+  char name[DIRSIZ];
+
+  if((dp = nameiparent(path, name)) == 0)
+    return 0;
+
+  ilock(dp);
+
+  if((ip = dirlookup(dp, name, 0)) != 0){
+    iunlockput(dp);
+    ilock(ip);
+    if(type == T_FILE && (ip->type == T_FILE || ip->type == T_DEVICE))
+      return ip;
+    iunlockput(ip);
+    return 0;
+  }
+
+  if((ip = ialloc(dp->dev, type)) == 0)
+    panic("create: ialloc");
+
+  ilock(ip);
+  ip->major = major;
+  ip->minor = minor;
+  ip->nlink = 1;
+  if(type == T_DIR && minor > 0)
+    ip->size = minor * BSIZE;   // labx hashed directory: minor 个桶
+  iupdate(ip);
+
+  if(type == T_DIR){  // Create . and .. entries.
+    // No ip->nlink++ for ".": avoid cyclic ref count.
+    if(dirlink(ip, ".", ip->inum) < 0 || dirlink(ip, "..", dp->inum) < 0)
+      panic("create dots");
+  }
+
+  // labx hashed directory: 散列目录的桶满了 dirlink 会失败
+  if(dirlink(dp, name, ip->inum) < 0){
+    ip->nlink = 0;
+    iupdate(ip);
+    iunlockput(ip);
+    iunlockput(dp);
+    return 0;
+  }
+
+  if(type == T_DIR){
+    dp->nlink++;  // for ".."
+    iupdate(dp);
+  }
+
+  iunlockput(dp);
+
+  return ip;
+}
+
+uint64
+sys_open(void)
+{
+  char path[MAXPATH];
+  int fd, omode;
+  struct file *f;
+  struct inode *ip;
+  int n, nblk;
+
+  if((n = argstr(0, path, MAXPATH)) < 0 || argint(1, &omode) < 0)
+    return -1;
+
+  // labx hashed directory: 创建时目录项可能要写好几个桶
+  nblk = (omode & O_CREATE) ? DIROPBLOCKS : MAXOPBLOCKS;
+  begin_opn(nblk);
+
+  if(omode & O_CREATE){
+    ip = create(path, T_FILE, 0, 0);
+    if(ip == 0){
+      end_opn(nblk);
+      return -1;
+    }
+  } else {
+    if((ip = namei(path)) == 0){
+      end_opn(nblk);
+      return -1;
+    }
+    ilock(ip);
+    if(ip->type == T_DIR && omode != O_RDONLY){
+      iunlockput(ip);
+      end_opn(nblk);
+      return -1;
+    }
+  }
+
+  if(ip->type == T_DEVICE && (ip->major < 0 || ip->major >= NDEV)){
+    iunlockput(ip);
+    end_opn(nblk);
+    return -1;
+  }
+
+  if((f = filealloc()) == 0 || (fd = fdalloc(f)) < 0){
+    if(f)
+      fileclose(f);
+    iunlockput(ip);
+    end_opn(nblk);
+    return -1;
+  }
+
+  if(ip->type == T_DEVICE){
+    f->type = FD_DEVICE;
+    f->major = ip->major;
+  } else {
+    f->type = FD_INODE;
+    f->off = 0;
+  }
+  f->ip = ip;
+  f->readable = !(omode & O_WRONLY);
+  f->writable = (omode & O_WRONLY) || (omode & O_RDWR);
+
+  if((omode & O_TRUNC) && ip->type == T_FILE){
+    itrunc(ip);
+  }
+
+  iunlock(ip);
+  end_opn(nblk);
+
+  return fd;
+}
+
+uint64
+sys_mkdir(void)
+{
+  char path[MAXPATH];
+  struct inode *ip;
+
+  begin_opn(DIROPBLOCKS);
+  if(argstr(0, path, MAXPATH) < 0 || (ip = create(path, T_DIR, 0, 0)) == 0){
+    end_opn(DIROPBLOCKS);
+    return -1;
+  }
+  iunlockput(ip);
+  end_opn(DIROPBLOCKS);
+  return 0;
+}
+
+uint64
+sys_mknod(void)
+{
+  struct inode *ip;
+  char path[MAXPATH];
+  int major, minor;
+
+  begin_opn(DIROPBLOCKS);
+  if((argstr(0, path, MAXPATH)) < 0 ||
+     argint(1, &major) < 0 ||
+     argint(2, &minor) < 0 ||
+     (ip = create(path, T_DEVICE, major, minor)) == 0){
+    end_opn(DIROPBLOCKS);
+    return -1;
+  }
+  iunlockput(ip);
+  end_opn(DIROPBLOCKS);
+  return 0;
+}
+
+uint64
+sys_chdir(void)
+{
+  char path[MAXPATH];
+  struct inode *ip;
+  struct proc *p = myproc();
+  
+  begin_op();
+  if(argstr(0, path, MAXPATH) < 0 || (ip = namei(path)) == 0){
+    end_op();
+    return -1;
+  }
+  ilock(ip);
+  if(ip->type != T_DIR){
+    iunlockput(ip);
+    end_op();
+    return -1;
+  }
+  iunlock(ip);
+  iput(p->cwd);
+  end_op();
+  p->cwd = ip;
+  return 0;
+}
+
+// 把用户态的 argv 数组拷进内核，每个参数一页，argv 最多 MAXARG 项
+// 失败返回 -1，无论成功与否都要用 freeargv() 释放
+static int
+fetchargv(uint64 uargv, char **argv)
+{
+  int i;
+  uint64 uarg;
+
+  memset(argv, 0, MAXARG*sizeof(char*));
+  for(i=0;; i++){
+    if(i >= MAXARG){
+      return -1;
+    }
+    if(fetchaddr(uargv+sizeof(uint64)*i, (uint64*)&uarg) < 0){
+      return -1;
+    }
+    if(uarg == 0){
+      argv[i] = 0;
+      break;
+    }
+    argv[i] = kalloc();
+    if(argv[i] == 0)
+      return -1;
+    if(fetchstr(uarg, argv[i], PGSIZE) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+static void
+freeargv(char **argv)
+{
+  int i;
+
+  for(i = 0; i < MAXARG && argv[i] != 0; i++)
+    kfree(argv[i]);
+}
+
+uint64
+sys_exec(void)
+{
+  char path[MAXPATH], *argv[MAXARG];
+  uint64 uargv;
+  int ret;
+
+  if(argstr(0, path, MAXPATH) < 0 || argaddr(1, &uargv) < 0){
+    return -1;
+  }
+  ret = -1;
+  if(fetchargv(uargv, argv) == 0)
+    ret = exec(path, argv);
+  freeargv(argv);
+  return ret;
+}
+
+// labx spawn
+// int spawn(char *path, char **argv, struct spawn_action *act, int nact);
+// 相当于 fork() + 按 act 调整文件描述符 + exec()，但不复制父进程的内存，
+// 返回子进程的 pid，exec 失败时返回 -1 并且不会留下子进程
+uint64
+sys_spawn(void)
+{
+  char path[MAXPATH], *argv[MAXARG];
+  struct spawn_action act[SPAWN_MAXACT];
+  uint64 uargv, uact;
+  int nact, ret;
+
+  if(argstr(0, path, MAXPATH) < 0 || argaddr(1, &uargv) < 0 ||
+     argaddr(2, &uact) < 0 || argint(3, &nact) < 0)
+    return -1;
+  if(nact < 0 || nact > SPAWN_MAXACT)
+    return -1;
+  if(nact > 0 &&
+     copyin(myproc()->pagetable, (char*)act, uact, nact*sizeof(act[0])) < 0)
+    return -1;
+
+  ret = -1;
+  if(fetchargv(uargv, argv) == 0)
+    ret = spawn(path, argv, act, nact);
+  freeargv(argv);
+  return ret;
+}
+
+// pipe() 和 pipe2() 的公共部分，size 为 0 表示默认大小
+static int
+pipefds(uint64 fdarray, int size)
+{
+  struct file *rf, *wf;
+  int fd0, fd1;
+  struct proc *p = myproc();
+
+  if(pipealloc(&rf, &wf, size) < 0)
+    return -1;
+  fd0 = -1;
+  if((fd0 = fdalloc(rf)) < 0 || (fd1 = fdalloc(wf)) < 0){
+    if(fd0 >= 0)
+      p->ofile[fd0] = 0;
+    fileclose(rf);
+    fileclose(wf);
+    return -1;
+  }
+  if(copyout(p->pagetable, fdarray, (char*)&fd0, sizeof(fd0)) < 0 ||
+     copyout(p->pagetable, fdarray+sizeof(fd0), (char *)&fd1, sizeof(fd1)) < 0){
+    p->ofile[fd0] = 0;
+    p->ofile[fd1] = 0;
+    fileclose(rf);
+    fileclose(wf);
+    return -1;
+  }
+  return 0;
+}
+
+uint64
+sys_pipe(void)
+{
+  uint64 fdarray; // user pointer to array of two integers
+
+  if(argaddr(0, &fdarray) < 0)
+    return -1;
+  return pipefds(fdarray, 0);
+}
+
+// labx pipe2
+// int pipe2(int fds[2], int size); 缓冲区为 size 字节的 pipe，
+// size 必须是 2 的幂且不超过 PIPEMAX，0 表示默认的 PIPESIZE
+uint64
+sys_pipe2(void)
+{
+  uint64 fdarray;
+  int size;
+
+  if(argaddr(0, &fdarray) < 0 || argint(1, &size) < 0)
+    return -1;
+  return pipefds(fdarray, size);
+}
+
+// labx splice
+// int splice(int fd_in, int fd_out, int n); 在内核里把最多 n 字节
+// 从 fd_in 搬到 fd_out，返回搬了多少，0 表示 fd_in 没有更多数据了。
+// 至少一端是 pipe 时数据直接进出 pipe 的页，见 filesplice()
+uint64
+sys_splice(void)
+{
+  struct file *in, *out;
+  int n;
+
+  if(argfd(0, 0, &in) < 0 || argfd(1, 0, &out) < 0 || argint(2, &n) < 0)
+    return -1;
+  return filesplice(in, out, n);
+}
+
+// labx readv/writev
+// 把用户的 iovec 数组一次拷进内核，检查每段的长度
+static int
+argiov(int n, struct iovec *iov, int *pniov)
+{
+  uint64 uiov;
+  int i, niov;
+
+  if(argaddr(n, &uiov) < 0 || argint(n+1, &niov) < 0)
+    return -1;
+  if(niov < 0 || niov > IOV_MAX)
+    return -1;
+  if(copyin(myproc()->pagetable, (char*)iov, uiov, niov*sizeof(iov[0])) < 0)
+    return -1;
+  for(i = 0; i < niov; i++)
+    if(iov[i].iov_len < 0)
+      return -1;
+  *pniov = niov;
+  return 0;
+}
+
+// int readv(int fd, struct iovec *iov, int niov);
+uint64
+sys_readv(void)
+{
+  struct file *f;
+  struct iovec iov[IOV_MAX];
+  int niov;
+
+  if(argfd(0, 0, &f) < 0 || argiov(1, iov, &niov) < 0)
+    return -1;
+  return filereadv(f, iov, niov);
+}
+
+// int writev(int fd, struct iovec *iov, int niov);
+uint64
+sys_writev(void)
+{
+  struct file *f;
+  struct iovec iov[IOV_MAX];
+  int niov;
+
+  if(argfd(0, 0, &f) < 0 || argiov(1, iov, &niov) < 0)
+    return -1;
+  return filewritev(f, iov, niov);
+}
+
+// labx poll
+// int poll(struct pollfd *fds, int n, int timeout); timeout 以 tick 为单位，
+// 小于 0 一直等。返回就绪的 fd 个数，超时返回 0
+uint64
+sys_poll(void)
+{
+  uint64 fds;
+  int n, timeout;
+
+  if(argaddr(0, &fds) < 0 || argint(1, &n) < 0 || argint(2, &timeout) < 0)
+    return -1;
+  return poll(fds, n, timeout);
+}
+
+// labx eventfd
+// int eventfd(int initval); 返回一个计数器初值为 initval 的 eventfd
+uint64
+sys_eventfd(void)
+{
+  struct file *f;
+  int fd, initval;
+
+  if(argint(0, &initval) < 0 || initval < 0)
+    return -1;
+  if((f = filealloc()) == 0)
+    return -1;
+  if((fd = fdalloc(f)) < 0){
+    fileclose(f);
+    return -1;
+  }
+  f->type = FD_EVENT;
+  f->readable = 1;
+  f->writable = 1;
+  f->count = initval;
+  f->pollq.head = 0;
+  return fd;
+}
+
+// labx getdents
+// int getdents(int fd, struct xdirent *buf, int n);
+// 从目录 fd 的当前位置读最多 n 个目录项，返回读到的个数，0 表示读完了
+uint64
+sys_getdents(void)
+{
+  struct file *f;
+  uint64 p;
+  int n;
+
+  if(argfd(0, 0, &f) < 0 || argaddr(1, &p) < 0 || argint(2, &n) < 0)
+    return -1;
+  if(f->type != FD_INODE || !f->readable || n < 0)
+    return -1;
+  return readdirents(f->ip, &f->off, p, n);
+}
+
+// labx iostat
+// int iostat(struct iostat *st);
+uint64
+sys_iostat(void)
+{
+  struct iostat st;
+  uint64 p;
+
+  if(argaddr(0, &p) < 0)
+    return -1;
+  virtio_disk_stat(&st);
+  if(copyout(myproc()->pagetable, p, (char *)&st, sizeof(st)) < 0)
+    return -1;
+  return 0;
+}
+
+// labx hashed directory
+// int hmkdir(char *path, int nbucket);
+// 建一个有 nbucket 个桶的散列目录，最多放 nbucket*(DPB-1) 项
+uint64
+sys_hmkdir(void)
+{
+  char path[MAXPATH];
+  struct inode *ip;
+  int n;
+
+  if(argstr(0, path, MAXPATH) < 0 || argint(1, &n) < 0)
+    return -1;
+  if(n < 1 || n > MAXFILE)
+    return -1;
+  begin_opn(DIROPBLOCKS);
+  if((ip = create(path, T_DIR, 0, n)) == 0){
+    end_opn(DIROPBLOCKS);
+    return -1;
+  }
+  iunlockput(ip);
+  end_opn(DIROPBLOCKS);
+  return 0;
+}
+
+// labx dcache
+// int dcstat(struct dcstat *st);
+uint64
+sys_dcstat(void)
+{
+  struct dcstat st;
+  uint64 p;
+
+  if(argaddr(0, &p) < 0)
+    return -1;
+  dcache_stat(&st);
+  if(copyout(myproc()->pagetable, p, (char *)&st, sizeof(st)) < 0)
+    return -1;
+  return 0;
+}
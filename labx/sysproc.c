@@ -0,0 +1,284 @@
+#include "types.h"
+#include "riscv.h"
+#include "param.h"
+#include "defs.h"
+#include "date.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "sysinfo.h"
+
+uint64
+sys_exit(void)
+{
+  int n;
+  if(argint(0, &n) < 0)
+    return -1;
+  exit(n);
+  return 0;  // not reached
+}
+
+uint64
+sys_getpid(void)
+{
+  return myproc()->pid;
+}
+
+uint64
+sys_fork(void)
+{
+  return fork();
+}
+
+uint64
+sys_wait(void)
+{
+  uint64 p;
+  if(argaddr(0, &p) < 0)
+    return -1;
+  return wait(p);
+}
+
+uint64
+sys_sbrk(void)
+{
+  int addr;
+  int n;
+
+  if(argint(0, &n) < 0)
+    return -1;
+  
+  addr = myproc()->sz;
+  if(growproc(n) < 0)
+    return -1;
+  return addr;
+}
+
+uint64
+sys_sleep(void)
+{
+  int n;
+  uint ticks0;
+
+
+  if(argint(0, &n) < 0)
+    return -1;
+  acquire(&tickslock);
+  ticks0 = ticks;
+  while(ticks - ticks0 < n){
+    if(myproc()->killed){
+      release(&tickslock);
+      return -1;
+    }
+    sleep(&ticks, &tickslock);
+  }
+  release(&tickslock);
+  return 0;
+}
+
+// lab3 page table 3 - Detecting which pages have been accessed
+
+/*
+Your job is to implement pgaccess(), a system call that reports which pages have been accessed. 
+The system call takes three arguments. 
+1 it takes the starting virtual address of the first user page to check. 
+2 it takes the number of pages to check. 
+3 it takes a user address to a buffer to store the results into a bitmask (a datastructure 
+that uses one bit per page and where the first page corresponds to the least significant bit). 
+*/
+
+
+#ifdef LAB_PGTBL
+int
+sys_pgaccess(void)
+{
+  // get user parameters
+
+  // starting virtual address of the first user page to check
+  uint64 starting_va;
+  if(argaddr(0, &starting_va) < 0)
+    return -1;
+
+  // the number of pages to check
+  int num;
+  if(argint(1, &num) < 0)
+    return -1;
+
+  // a user address to a buffer to store the results into a bitmask
+  uint64 ans_buff;
+  if(argaddr(2, &ans_buff) < 0)
+    return -1;
+
+  return pgaccess((void*)starting_va, num, (void*)ans_buff);
+}
+#endif
+
+uint64
+sys_kill(void)
+{
+  int pid;
+
+  if(argint(0, &pid) < 0)
+    return -1;
+  return kill(pid);
+}
+
+// return how many clock tick interrupts have occurred
+// since start.
+uint64
+sys_uptime(void)
+{
+  uint xticks;
+
+  acquire(&tickslock);
+  xticks = ticks;
+  release(&tickslock);
+  return xticks;
+}
+
+// lab2 trace
+uint64
+sys_trace(void)
+{
+  int mask;
+  // 从寄存器中取值 (控制台入参)，存入 mask
+  if (argint(0, &mask) < 0) {
+    return -1;
+  }
+  
+  // 将寄存器中的 mask 给 this 进程的 mask
+  myproc()->mask = mask;
+  return 0;
+}
+
+// lab2 sysinfo
+uint64
+sys_sysinfo(void)
+{
+  
+  // 从用户态读取用户的结构体指针
+  uint64 addr;
+  if(argaddr(0, &addr) < 0) {
+    return -1;
+  }
+
+  // 定义一个存储 sysinfo 的结构体
+  struct sysinfo info;
+
+  // 调用自己编写的统计函数并赋值
+  info.freemem = sysinfo_free_mem();
+  info.nproc = sysinfo_free_proc();
+
+  // 获得当前进程的控制信息
+  struct proc *p = myproc();
+
+  // 复制 sysinfo 结构体 info 到用户传来的地址
+  // 用户传进来的虚拟地址是 addr，我们通过 pagetable 将数据复制到物理地址
+  if(copyout(p->pagetable, addr, (char *)&info, sizeof(info)) < 0) {
+    return -1;
+  }
+  
+  // printf("小夫，我要进来 sysproc.c 了！\n");
+  // printf("小夫，我要进来 sysproc.c 了！\n");
+  // printf("小夫，我要进来 sysproc.c 了！\n");
+
+  return 0;
+}
+
+// labx clone
+// int clone(void (*fn)(void *), void *stack, void *arg);
+// stack 是一整页用户栈的起始地址，新线程从 fn(arg) 开始执行
+uint64
+sys_clone(void)
+{
+  uint64 fn, stack, arg;
+
+  if(argaddr(0, &fn) < 0)
+    return -1;
+  if(argaddr(1, &stack) < 0)
+    return -1;
+  if(argaddr(2, &arg) < 0)
+    return -1;
+
+  return clone(fn, stack, arg);
+}
+
+// labx join
+// int join(void **stack); 等待一个子线程退出，返回它的 pid，
+// 并把 clone 时传入的栈地址写回 *stack，方便用户态释放
+uint64
+sys_join(void)
+{
+  uint64 addr;
+
+  if(argaddr(0, &addr) < 0)
+    return -1;
+
+  return join(addr);
+}
+
+// labx futex
+// int futex_wait(int *addr, int val); *addr == val 时睡眠直到 futex_wake
+uint64
+sys_futex_wait(void)
+{
+  uint64 addr;
+  int val;
+
+  if(argaddr(0, &addr) < 0)
+    return -1;
+  if(argint(1, &val) < 0)
+    return -1;
+
+  return futex_wait(addr, val);
+}
+
+// labx futex
+// int futex_wake(int *addr, int n); 唤醒最多 n 个等待者，返回唤醒的个数
+uint64
+sys_futex_wake(void)
+{
+  uint64 addr;
+  int n;
+
+  if(argaddr(0, &addr) < 0)
+    return -1;
+  if(argint(1, &n) < 0)
+    return -1;
+
+  return futex_wake(addr, n);
+}
+
+// labx chan
+// void *chan_create(void); 返回一页 fork 时父子共享的内存，失败返回 0
+uint64
+sys_chan_create(void)
+{
+  return chancreate();
+}
+
+// main.c 里每个 hart 启动时置位
+extern volatile int cpuonline;
+
+// labx setaffinity
+// int setaffinity(int mask); 只允许当前进程在 mask 里的 CPU 上运行，0 表示不限制。
+// 之后 fork/clone/spawn 出来的进程继承 mask
+uint64
+sys_setaffinity(void)
+{
+  int mask;
+  struct proc *p = myproc();
+
+  if(argint(0, &mask) < 0)
+    return -1;
+  // 至少要有一个已经启动的 CPU，不然永远不会被调度
+  if(mask != 0 && (mask & cpuonline) == 0)
+    return -1;
+  acquire(&p->lock);
+  p->cpumask = mask;
+  release(&p->lock);
+  // 当前 CPU 不在 mask 里，让出去，调度器会在允许的 CPU 上重新运行它
+  if(mask != 0 && ((mask >> cpuid()) & 1) == 0)
+    yield();
+  return 0;
+}
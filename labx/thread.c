@@ -0,0 +1,130 @@
+#include "kernel/types.h"
+#include "kernel/riscv.h"
+#include "user/user.h"
+
+// labx clone
+// 基于 clone()/join() 的用户态线程库
+
+// 线程栈是 malloc 出来的一整页，malloc 返回的指针和入口参数放在栈页的上方
+struct tstart {
+  void *raw;              // malloc() 返回的指针，join 之后 free
+  void (*fn)(void *);
+  void *arg;
+};
+
+// 新线程从这里开始，fn 返回后线程退出
+static void
+thread_start(void *arg)
+{
+  struct tstart *ts = arg;
+
+  ts->fn(ts->arg);
+  exit(0);
+}
+
+// 创建线程执行 fn(arg)，返回线程的 pid，失败返回 -1
+// malloc 不是线程安全的，请只在一个线程里创建线程
+int
+thread_create(void (*fn)(void *), void *arg)
+{
+  char *raw, *stack;
+  struct tstart *ts;
+  int pid;
+
+  if((raw = malloc(2*PGSIZE + sizeof(struct tstart))) == 0)
+    return -1;
+  stack = (char *)PGROUNDUP((uint64)raw);
+  ts = (struct tstart *)(stack + PGSIZE);
+  ts->raw = raw;
+  ts->fn = fn;
+  ts->arg = arg;
+
+  if((pid = clone(thread_start, stack, ts)) < 0)
+    free(raw);
+  return pid;
+}
+
+// 等待任意一个子线程退出并释放它的栈，返回它的 pid
+int
+thread_join(void)
+{
+  void *stack;
+  struct tstart *ts;
+  int pid;
+
+  if((pid = join(&stack)) < 0)
+    return -1;
+  ts = (struct tstart *)((char *)stack + PGSIZE);
+  free(ts->raw);
+  return pid;
+}
+
+// labx futex
+// 互斥锁：没有竞争时 lock/unlock 各只有一次原子操作，不进内核；
+// 有竞争时把状态置为 2，在 futex 上睡眠，unlock 看到 2 才去 futex_wake。
+
+void
+mutex_init(struct mutex *m)
+{
+  m->v = 0;
+}
+
+void
+mutex_lock(struct mutex *m)
+{
+  int c;
+
+  if((c = __sync_val_compare_and_swap(&m->v, 0, 1)) == 0)
+    return;
+  if(c != 2)
+    c = __atomic_exchange_n(&m->v, 2, __ATOMIC_ACQUIRE);
+  while(c != 0){
+    futex_wait(&m->v, 2);
+    c = __atomic_exchange_n(&m->v, 2, __ATOMIC_ACQUIRE);
+  }
+}
+
+void
+mutex_unlock(struct mutex *m)
+{
+  if(__sync_fetch_and_sub(&m->v, 1) != 1){
+    __atomic_store_n(&m->v, 0, __ATOMIC_RELEASE);
+    futex_wake(&m->v, 1);
+  }
+}
+
+// 条件变量：等待者记下 seq 再放锁，signal 改了 seq 之后
+// futex_wait 就不会睡下去，所以放锁和睡眠之间的唤醒不会丢。
+// 和 pthread 一样可能有虚假唤醒，调用者要在循环里检查条件。
+
+void
+cond_init(struct cond *c)
+{
+  c->seq = 0;
+}
+
+void
+cond_wait(struct cond *c, struct mutex *m)
+{
+  int seq = __atomic_load_n(&c->seq, __ATOMIC_RELAXED);
+
+  mutex_unlock(m);
+  futex_wait(&c->seq, seq);
+  // 不知道还有没有别人在等锁，直接按有竞争 (2) 上锁
+  while(__atomic_exchange_n(&m->v, 2, __ATOMIC_ACQUIRE) != 0)
+    futex_wait(&m->v, 2);
+}
+
+void
+cond_signal(struct cond *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex_wake(&c->seq, 1);
+}
+
+void
+cond_broadcast(struct cond *c)
+{
+  __sync_fetch_and_add(&c->seq, 1);
+  futex_wake(&c->seq, 0x7fffffff);
+}
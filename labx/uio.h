@@ -0,0 +1,9 @@
+// labx readv/writev
+// 一段用户内存，readv/writev 一次处理一个数组
+
+#define IOV_MAX 16      // 一次 readv/writev 最多的段数
+
+struct iovec {
+  void *iov_base;       // 用户地址
+  int iov_len;          // 字节数
+};
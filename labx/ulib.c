@@ -0,0 +1,246 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+// labx printf
+// 程序的入口 (Makefile 里的 -e _main)，main 返回时也走 exit()，
+// 这样缓冲的输出不会丢
+void
+_main(int argc, char *argv[])
+{
+  extern int main(int, char**);
+
+  exit(main(argc, argv));
+}
+
+char*
+strcpy(char *s, const char *t)
+{
+  char *os;
+
+  os = s;
+  while((*s++ = *t++) != 0)
+    ;
+  return os;
+}
+
+int
+strcmp(const char *p, const char *q)
+{
+  while(*p && *p == *q)
+    p++, q++;
+  return (uchar)*p - (uchar)*q;
+}
+
+uint
+strlen(const char *s)
+{
+  int n;
+
+  for(n = 0; s[n]; n++)
+    ;
+  return n;
+}
+
+void*
+memset(void *dst, int c, uint n)
+{
+  char *cdst = (char *) dst;
+  int i;
+  for(i = 0; i < n; i++){
+    cdst[i] = c;
+  }
+  return dst;
+}
+
+char*
+strchr(const char *s, char c)
+{
+  for(; *s; s++)
+    if(*s == c)
+      return (char*)s;
+  return 0;
+}
+
+// labx getline
+// 每个 fd 一个输入缓冲区 (第一次读时 malloc)，一次 read 读进最多 4K，
+// getline() 再从里面一行一行取，不用每个字节一次 read。
+// 缓冲区里读多了的数据别的进程看不到，fork 出来的子进程会带着一份。
+
+#define RBUFSIZE 4096
+
+struct rbuf {
+  int r;                  // 下一个要取的字节
+  int n;                  // buf 里的字节数
+  char buf[RBUFSIZE];
+  char line[RBUFSIZE+1];  // getline() 返回的行
+};
+
+static struct rbuf *rbufs[NOFILE];
+
+static struct rbuf*
+getrbuf(int fd)
+{
+  struct rbuf *b;
+
+  if(fd < 0 || fd >= NOFILE)
+    return 0;
+  if((b = rbufs[fd]) != 0)
+    return b;
+  if((b = malloc(sizeof(*b))) == 0)
+    return 0;
+  b->r = b->n = 0;
+  rbufs[fd] = b;
+  return b;
+}
+
+// 缓冲区空了就 read 一次，返回读到的字节数
+static int
+fill(int fd, struct rbuf *b)
+{
+  int n;
+
+  if(b->r < b->n)
+    return b->n - b->r;
+  if((n = read(fd, b->buf, RBUFSIZE)) < 0)
+    n = 0;
+  b->r = 0;
+  b->n = n;
+  return n;
+}
+
+// 读一行到 *lp 指向的内部缓冲区 (下次调用前有效)，行尾的 '\n' 保留，
+// 返回行的长度，EOF 返回 0，出错返回 -1。超过 4K 的行分几次返回。
+int
+getline(int fd, char **lp)
+{
+  struct rbuf *b;
+  int i, len;
+  char c;
+
+  if((b = getrbuf(fd)) == 0)
+    return -1;
+  len = 0;
+  while(len < RBUFSIZE && fill(fd, b) > 0){
+    for(i = b->r; i < b->n && len < RBUFSIZE; ){
+      c = b->buf[i++];
+      b->line[len++] = c;
+      if(c == '\n')
+        break;
+    }
+    b->r = i;
+    if(len > 0 && b->line[len-1] == '\n')
+      break;
+  }
+  b->line[len] = '\0';
+  *lp = b->line;
+  return len;
+}
+
+// close() 之后 fd 可能是另一个文件，丢掉缓冲的数据
+void
+lineclose(int fd)
+{
+  if(fd >= 0 && fd < NOFILE && rbufs[fd]){
+    free(rbufs[fd]);
+    rbufs[fd] = 0;
+  }
+}
+
+// labx getline: gets() 还是一次读一个字节，不用上面的缓冲区。
+// sh < 脚本 时，脚本里读 stdin 的命令要从 sh 读到的下一行接着读。
+char*
+gets(char *buf, int max)
+{
+  int i, cc;
+  char c;
+
+  for(i=0; i+1 < max; ){
+    cc = read(0, &c, 1);
+    if(cc < 1)
+      break;
+    buf[i++] = c;
+    if(c == '\n' || c == '\r')
+      break;
+  }
+  buf[i] = '\0';
+  return buf;
+}
+
+int
+stat(const char *n, struct stat *st)
+{
+  int fd;
+  int r;
+
+  fd = open(n, O_RDONLY);
+  if(fd < 0)
+    return -1;
+  r = fstat(fd, st);
+  close(fd);
+  return r;
+}
+
+int
+atoi(const char *s)
+{
+  int n;
+
+  n = 0;
+  while('0' <= *s && *s <= '9')
+    n = n*10 + *s++ - '0';
+  return n;
+}
+
+void*
+memmove(void *vdst, const void *vsrc, int n)
+{
+  char *dst;
+  const char *src;
+
+  dst = vdst;
+  src = vsrc;
+  if (src > dst) {
+    while(n-- > 0)
+      *dst++ = *src++;
+  } else {
+    dst += n;
+    src += n;
+    while(n-- > 0)
+      *--dst = *--src;
+  }
+  return vdst;
+}
+
+int
+memcmp(const void *s1, const void *s2, uint n)
+{
+  const char *p1 = s1, *p2 = s2;
+  while (n-- > 0) {
+    if (*p1 != *p2) {
+      return *p1 - *p2;
+    }
+    p1++;
+    p2++;
+  }
+  return 0;
+}
+
+void *
+memcpy(void *dst, const void *src, uint n)
+{
+  return memmove(dst, src, n);
+}
+
+// labx pingpong
+// start.c 打开了 mcounteren/scounteren 的 TM 位，用户态可以直接读 time CSR
+uint64
+rdtime(void)
+{
+  uint64 x;
+
+  asm volatile("rdtime %0" : "=r" (x));
+  return x;
+}
@@ -0,0 +1,249 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "kernel/riscv.h"
+#include "user/user.h"
+
+// labx malloc
+// 原来是 K&R 的首次适配分配器，每次 malloc 都要沿空闲链表找，sbrk 也很零碎。
+// 现在小块 (连头部 <= 2048 字节) 按 2 的幂分成 7 类，每类一个空闲链表，
+// malloc/free 都是 O(1)；某一类的链表空了，就拿一页切成这一类的块。
+// 大块按页分配，空闲的页段按地址排序串在 freepages 上，free 时和相邻的段合并。
+// 页不够时 sbrk，每次至少是上一次的两倍 (最多 MAXGROW 页)。
+
+struct header {
+  uint64 size;            // 整个块的字节数，包括头部
+  struct header *next;    // 空闲时串在链表上
+};
+
+#define HDRSIZE   sizeof(struct header)
+#define MINSHIFT  5                             // 最小的块 32 字节
+#define NCLASS    7                             // 32, 64, ... 2048
+#define MAXSMALL  (1UL << (MINSHIFT+NCLASS-1))
+#define MINGROW   4                             // sbrk 的页数
+#define MAXGROW   256
+
+static struct header *freelist[NCLASS];
+static struct header *freepages;
+static uint64 growpages = MINGROW;
+
+static int
+sizeclass(uint64 size)
+{
+  int c;
+
+  for(c = 0; (1UL << (MINSHIFT+c)) < size; c++)
+    ;
+  return c;
+}
+
+// 把页段 h 按地址插回 freepages，和前后相邻的段合并
+static void
+pagefree(struct header *h)
+{
+  struct header *p, *prev;
+
+  prev = 0;
+  for(p = freepages; p != 0 && p < h; p = p->next)
+    prev = p;
+
+  if(p != 0 && (char*)h + h->size == (char*)p){
+    h->size += p->size;
+    h->next = p->next;
+  } else {
+    h->next = p;
+  }
+
+  if(prev == 0){
+    freepages = h;
+  } else if((char*)prev + prev->size == (char*)h){
+    prev->size += h->size;
+    prev->next = h->next;
+  } else {
+    prev->next = h;
+  }
+}
+
+// 向内核要至少 npages 页放进 freepages
+static int
+morecore(uint64 npages)
+{
+  char *p;
+  uint64 n;
+  struct header *h;
+
+  // 别人 sbrk 过零碎的大小，先把堆顶对齐到页
+  p = sbrk(0);
+  if((uint64)p % PGSIZE != 0 && sbrk(PGSIZE - (uint64)p % PGSIZE) == (char*)-1)
+    return -1;
+
+  // sbrk 的参数是 int
+  if(npages * PGSIZE > 0x7fffffff)
+    return -1;
+  n = npages > growpages ? npages : growpages;
+  if((p = sbrk(n * PGSIZE)) == (char*)-1){
+    // 内存快用完了，只要够用的
+    n = npages;
+    if((p = sbrk(n * PGSIZE)) == (char*)-1)
+      return -1;
+  } else if(growpages < MAXGROW){
+    growpages *= 2;
+  }
+
+  h = (struct header*)p;
+  h->size = n * PGSIZE;
+  pagefree(h);
+  return 0;
+}
+
+// 首次适配地取 npages 页，多的留在 freepages 上
+static struct header*
+pagealloc(uint64 npages)
+{
+  struct header *p, **pp, *rest;
+  uint64 size;
+
+  size = npages * PGSIZE;
+  for(;;){
+    for(pp = &freepages; (p = *pp) != 0; pp = &p->next){
+      if(p->size == size){
+        *pp = p->next;
+        return p;
+      }
+      if(p->size > size){
+        rest = (struct header*)((char*)p + size);
+        rest->size = p->size - size;
+        rest->next = p->next;
+        *pp = rest;
+        p->size = size;
+        return p;
+      }
+    }
+    if(morecore(npages) < 0)
+      return 0;
+  }
+}
+
+// 拿一页切成第 c 类的块
+static int
+refill(int c)
+{
+  struct header *pg, *h;
+  uint64 bsize;
+  char *p;
+
+  if((pg = pagealloc(1)) == 0)
+    return -1;
+  bsize = 1UL << (MINSHIFT+c);
+  for(p = (char*)pg; p + bsize <= (char*)pg + PGSIZE; p += bsize){
+    h = (struct header*)p;
+    h->size = bsize;
+    h->next = freelist[c];
+    freelist[c] = h;
+  }
+  return 0;
+}
+
+void
+free(void *ap)
+{
+  struct header *h;
+  int c;
+
+  if(ap == 0)
+    return;
+  h = (struct header*)ap - 1;
+  if(h->size <= MAXSMALL){
+    c = sizeclass(h->size);
+    h->next = freelist[c];
+    freelist[c] = h;
+  } else {
+    pagefree(h);
+  }
+}
+
+void*
+malloc(uint nbytes)
+{
+  struct header *h;
+  uint64 size;
+  int c;
+
+  size = (uint64)nbytes + HDRSIZE;
+  if(size <= MAXSMALL){
+    c = sizeclass(size);
+    if(freelist[c] == 0 && refill(c) < 0)
+      return 0;
+    h = freelist[c];
+    freelist[c] = h->next;
+  } else {
+    if((h = pagealloc((size + PGSIZE - 1) / PGSIZE)) == 0)
+      return 0;
+  }
+  return (void*)(h + 1);
+}
+
+// labx malloc: arena
+// 一次性释放的一大堆小对象：从 malloc 来的大块里顺序切，
+// 不记录每个对象，arena_destroy() 把大块一起还给 malloc。
+
+#define ARENACHUNK (4*PGSIZE)
+
+struct chunk {
+  struct chunk *next;
+  uint64 pad;             // 保持 16 字节对齐
+};
+
+struct arena {
+  struct chunk *chunks;
+  char *cur;              // 当前大块里下一个可用的字节
+  char *end;
+};
+
+struct arena*
+arena_create(void)
+{
+  struct arena *a;
+
+  if((a = malloc(sizeof(*a))) == 0)
+    return 0;
+  a->chunks = 0;
+  a->cur = a->end = 0;
+  return a;
+}
+
+void*
+arena_alloc(struct arena *a, uint nbytes)
+{
+  struct chunk *c;
+  uint64 n, size;
+  void *p;
+
+  n = ((uint64)nbytes + 15) & ~15UL;
+  if(a->cur == 0 || a->cur + n > a->end){
+    size = sizeof(struct chunk) + n;
+    if(size < ARENACHUNK - HDRSIZE)
+      size = ARENACHUNK - HDRSIZE;   // 连 malloc 的头部正好 4 页
+    if((c = malloc(size)) == 0)
+      return 0;
+    c->next = a->chunks;
+    a->chunks = c;
+    a->cur = (char*)(c + 1);
+    a->end = (char*)c + size;
+  }
+  p = a->cur;
+  a->cur += n;
+  return p;
+}
+
+void
+arena_destroy(struct arena *a)
+{
+  struct chunk *c, *next;
+
+  for(c = a->chunks; c != 0; c = next){
+    next = c->next;
+    free(c);
+  }
+  free(a);
+}
@@ -0,0 +1,308 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+#include "user/user.h"
+
+// labx updatedb
+// 遍历整个文件系统，生成 find -l 用的索引：
+//   /locatedb       所有普通文件的路径，按文件名 (最后一段) 排序，一行一个
+//   /locatedb.dirs  每个目录的快照，给下一次增量更新用：
+//                   D<inum> <ver> <path> 一行，后面跟着 f<name> (文件) 和 d<name> (子目录)
+// 目录的 inum 和 ver (stat.ver，每次写目录加一) 都和快照一样，说明目录项没变，
+// 就直接用快照里的文件和子目录，不再读目录；子目录还是逐个 stat 检查。
+
+#define NDENT 8
+#define NHASH 64
+
+struct dir {
+  struct dir *hnext;
+  char *path;
+  uint inum, ver;
+  char *ents;               // 快照里这个目录的 f/d 行
+  int elen;
+};
+
+struct ent {
+  struct ent *next;
+  char type;                // 'f' 或 'd'
+  char name[DIRSIZ+1];
+};
+
+struct arena *arena;
+struct dir *dirs[NHASH];    // 旧快照，按路径哈希
+char **paths;               // 所有普通文件的路径
+int npath, maxpath;
+int dfd;                    // 新的 /locatedb.dirs
+int nscan, nreuse;
+
+void*
+xalloc(uint n)
+{
+  void *p;
+
+  if((p = arena_alloc(arena, n)) == 0){
+    fprintf(2, "updatedb: out of memory\n");
+    exit(1);
+  }
+  return p;
+}
+
+uint
+hash(char *s)
+{
+  uint h = 0;
+
+  while(*s)
+    h = h * 31 + *s++;
+  return h % NHASH;
+}
+
+struct dir*
+lookup(char *path)
+{
+  struct dir *d;
+
+  for(d = dirs[hash(path)]; d; d = d->hnext)
+    if(strcmp(d->path, path) == 0)
+      return d;
+  return 0;
+}
+
+// 读入旧的 /locatedb.dirs，没有就当作全部要扫描
+void
+loadold(void)
+{
+  struct stat st;
+  struct dir *d;
+  char *buf, *p, *q, *end;
+  int fd, n, m;
+
+  if((fd = open("/locatedb.dirs", O_RDONLY)) < 0)
+    return;
+  if(fstat(fd, &st) < 0 || (buf = xalloc(st.size + 1)) == 0){
+    close(fd);
+    return;
+  }
+  for(n = 0; n < st.size; n += m)
+    if((m = read(fd, buf + n, st.size - n)) <= 0)
+      break;
+  close(fd);
+  buf[n] = 0;
+  end = buf + n;
+
+  d = 0;
+  for(p = buf; p < end; p = q + 1){
+    if((q = strchr(p, '\n')) == 0)
+      break;
+    if(*p != 'D'){
+      if(d)
+        d->elen = q + 1 - d->ents;
+      continue;
+    }
+    *q = 0;
+    d = xalloc(sizeof(*d));
+    d->inum = atoi(p + 1);
+    while(*p && *p != ' ')
+      p++;
+    d->ver = atoi(++p);
+    while(*p && *p != ' ')
+      p++;
+    d->path = ++p;
+    d->ents = q + 1;
+    d->elen = 0;
+    d->hnext = dirs[hash(d->path)];
+    dirs[hash(d->path)] = d;
+  }
+}
+
+char*
+mkpath(char *dir, char *name)
+{
+  char *p;
+
+  p = xalloc(strlen(dir) + 1 + strlen(name) + 1);
+  strcpy(p, dir);
+  if(strcmp(dir, "/") != 0)
+    strcpy(p + strlen(p), "/");
+  strcpy(p + strlen(p), name);
+  return p;
+}
+
+void
+addpath(char *path)
+{
+  char **np;
+
+  if(npath == maxpath){
+    maxpath = maxpath ? maxpath * 2 : 256;
+    if((np = malloc(maxpath * sizeof(char*))) == 0){
+      fprintf(2, "updatedb: out of memory\n");
+      exit(1);
+    }
+    memmove(np, paths, npath * sizeof(char*));
+    free(paths);
+    paths = np;
+  }
+  paths[npath++] = path;
+}
+
+struct ent*
+newent(struct ent *next, char type, char *name, int len)
+{
+  struct ent *e;
+
+  e = xalloc(sizeof(*e));
+  e->next = next;
+  e->type = type;
+  memmove(e->name, name, len);
+  e->name[len] = 0;
+  return e;
+}
+
+// 自己的输出 /locatedb、/locatedb.dirs (以及 /locatedb.* 这样的临时文件) 不进索引，
+// 否则每次运行都会把上一次的结果当成普通文件记进去
+int
+isself(char *dir, char *name)
+{
+  return strcmp(dir, "/") == 0 && memcmp(name, "locatedb", 8) == 0 &&
+         (name[8] == 0 || name[8] == '.');
+}
+
+void
+walk(char *path)
+{
+  struct xdirent de[NDENT];
+  struct stat st;
+  struct dir *d;
+  struct ent *list, *e;
+  char *p, *q;
+  int fd, i, n;
+
+  if((fd = open(path, O_RDONLY)) < 0)
+    return;
+  if(fstat(fd, &st) < 0 || st.type != T_DIR){
+    close(fd);
+    return;
+  }
+
+  list = 0;
+  if((d = lookup(path)) != 0 && d->inum == st.ino && d->ver == st.ver){
+    nreuse++;
+    for(p = d->ents; p < d->ents + d->elen; p = q + 1){
+      q = strchr(p, '\n');
+      list = newent(list, p[0], p + 1, q - p - 1);
+    }
+  } else {
+    nscan++;
+    while((n = getdents(fd, de, NDENT)) > 0){
+      for(i = 0; i < n; i++){
+        if(!strcmp(de[i].name, ".") || !strcmp(de[i].name, ".."))
+          continue;
+        if(de[i].type == T_DIR)
+          list = newent(list, 'd', de[i].name, strlen(de[i].name));
+        else if(de[i].type == T_FILE)
+          list = newent(list, 'f', de[i].name, strlen(de[i].name));
+      }
+    }
+  }
+  close(fd);
+
+  // 先写完这个目录的快照，再进子目录
+  fprintf(dfd, "D%d %d %s\n", st.ino, st.ver, path);
+  for(e = list; e; e = e->next){
+    if(e->type == 'f' && isself(path, e->name))
+      continue;
+    fprintf(dfd, "%c%s\n", e->type, e->name);
+    if(e->type == 'f')
+      addpath(mkpath(path, e->name));
+  }
+  for(e = list; e; e = e->next)
+    if(e->type == 'd')
+      walk(mkpath(path, e->name));
+}
+
+char*
+basename(char *path)
+{
+  char *p, *b;
+
+  for(p = b = path; *p; p++)
+    if(*p == '/')
+      b = p + 1;
+  return b;
+}
+
+int
+pathcmp(char *a, char *b)
+{
+  int c;
+
+  if((c = strcmp(basename(a), basename(b))) != 0)
+    return c;
+  return strcmp(a, b);
+}
+
+void
+sort(char **v, int n)
+{
+  char *pivot, *t;
+  int i, j;
+
+  while(n > 1){
+    pivot = v[(n - 1) / 2];
+    for(i = 0, j = n - 1; ; i++, j--){
+      while(pathcmp(v[i], pivot) < 0)
+        i++;
+      while(pathcmp(v[j], pivot) > 0)
+        j--;
+      if(i >= j)
+        break;
+      t = v[i];
+      v[i] = v[j];
+      v[j] = t;
+    }
+    // 递归排小的一半，大的一半循环，栈深度 O(log n)
+    if(j + 1 < n - j - 1){
+      sort(v, j + 1);
+      v += j + 1;
+      n -= j + 1;
+    } else {
+      sort(v + j + 1, n - j - 1);
+      n = j + 1;
+    }
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i, t0;
+
+  t0 = uptime();
+  if((arena = arena_create()) == 0){
+    fprintf(2, "updatedb: out of memory\n");
+    exit(1);
+  }
+  loadold();
+
+  if((dfd = open("/locatedb.dirs", O_CREATE|O_TRUNC|O_WRONLY)) < 0){
+    fprintf(2, "updatedb: cannot create /locatedb.dirs\n");
+    exit(1);
+  }
+  walk("/");
+  close(dfd);
+
+  sort(paths, npath);
+  if((fd = open("/locatedb", O_CREATE|O_TRUNC|O_WRONLY)) < 0){
+    fprintf(2, "updatedb: cannot create /locatedb\n");
+    exit(1);
+  }
+  for(i = 0; i < npath; i++)
+    fprintf(fd, "%s\n", paths[i]);
+  close(fd);
+
+  printf("updatedb: %d files, %d dirs scanned, %d unchanged, %d ticks\n",
+         npath, nscan, nreuse, uptime() - t0);
+  exit(0);
+}
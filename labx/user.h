@@ -0,0 +1,114 @@
+struct stat;
+struct rtcdate;
+struct sysinfo;     // for lab2 sysinfo 入参
+struct spawn_action;
+struct iovec;
+struct pollfd;
+struct xdirent;
+struct iostat;
+struct dcstat;
+
+// system calls
+int fork(void);
+int exit(int) __attribute__((noreturn));
+int wait(int*);
+int pipe(int*);
+int write(int, const void*, int);
+int read(int, void*, int);
+int close(int);
+int kill(int);
+int exec(char*, char**);
+int open(const char*, int);
+int mknod(const char*, short, short);
+int unlink(const char*);
+int fstat(int fd, struct stat*);
+int link(const char*, const char*);
+int mkdir(const char*);
+int chdir(const char*);
+int dup(int);
+int getpid(void);
+char* sbrk(int);
+int sleep(int);
+int uptime(void);
+int trace(int);                  // lab2 add a prototype for this system call
+int sysinfo(struct sysinfo *);   // lab2 add the system call sysinfo 统计剩余内存数量 & 非空闲进程数量
+int pgaccess(void *base, int len, void *mask);  // lab3
+int clone(void (*)(void *), void *, void *);    // labx 创建共享地址空间的线程
+int join(void **);                              // labx 回收子线程
+int futex_wait(int *, int);                     // labx *addr == val 时睡眠
+int futex_wake(int *, int);                     // labx 唤醒最多 n 个等待者
+int spawn(char*, char**, struct spawn_action*, int); // labx fork + exec，不复制内存
+int pipe2(int*, int);                           // labx 指定缓冲区大小的 pipe
+int splice(int, int, int);                      // labx 在内核里从一个 fd 搬数据到另一个
+void *chan_create(void);                        // labx 一页 fork 时共享的内存，用作 chan
+int readv(int, struct iovec*, int);             // labx 读到多段内存
+int writev(int, struct iovec*, int);            // labx 写多段内存
+int poll(struct pollfd*, int, int);             // labx 等多个 fd 中任意一个就绪，超时以 tick 计
+int eventfd(int);                               // labx 计数器文件，读写 8 字节
+int getdents(int, struct xdirent*, int);        // labx 一次读多个目录项，带类型和大小
+int setaffinity(int);                           // labx 只在 mask 里的 CPU 上运行，0 不限制
+int iostat(struct iostat*);                     // labx 磁盘请求计数
+int hmkdir(const char*, int);                   // labx 建有 n 个桶的散列目录
+int dcstat(struct dcstat*);                     // labx 名字缓存的命中计数
+// labx printf
+// 不刷输出缓冲区的原始系统调用，见 printf.c
+int _fork(void);
+int _exit(int) __attribute__((noreturn));
+int _exec(char*, char**);
+int _spawn(char*, char**, struct spawn_action*, int);
+int _close(int);
+
+// ulib.c
+int stat(const char*, struct stat*);
+char* strcpy(char*, const char*);
+void *memmove(void*, const void*, int);
+char* strchr(const char*, char c);
+int strcmp(const char*, const char*);
+void fprintf(int, const char*, ...);
+void printf(const char*, ...);
+void fflush(int);                   // labx 写出 fd 缓冲的输出
+void setbuffered(int, int);         // labx 打开/关闭 fd 的输出缓冲
+char* gets(char*, int max);
+int getline(int, char**);           // labx 从 fd 的 4K 缓冲区里读一行
+void lineclose(int);                // labx 丢掉 fd 的输入缓冲区，close() 会调用
+uint64 rdtime(void);                // labx 读 time CSR
+#define TIMEHZ 10000000             // labx qemu virt 的 time CSR 是 10MHz
+uint strlen(const char*);
+void* memset(void*, int, uint);
+void* malloc(uint);
+void free(void*);
+int atoi(const char*);
+int memcmp(const void *, const void *, uint);
+void *memcpy(void *, const void *, uint);
+
+// thread.c
+// 基于 futex 的互斥锁和条件变量，全 0 就是初始状态
+struct mutex {
+  int v;          // 0 未上锁，1 上锁，2 上锁并且可能有人在等
+};
+struct cond {
+  int seq;        // 每次 signal/broadcast 加一
+};
+int thread_create(void (*)(void *), void *);
+int thread_join(void);
+void mutex_init(struct mutex *);
+void mutex_lock(struct mutex *);
+void mutex_unlock(struct mutex *);
+void cond_init(struct cond *);
+void cond_wait(struct cond *, struct mutex *);
+void cond_signal(struct cond *);
+void cond_broadcast(struct cond *);
+
+// chan.c
+struct chan;
+struct chan* chan_open(void);
+int chan_send(struct chan *, const void *, int);
+int chan_recv(struct chan *, void *, int);
+void chan_close(struct chan *);
+
+// umalloc.c
+// labx 一次性释放的分配区
+struct arena;
+struct arena* arena_create(void);
+void* arena_alloc(struct arena*, uint);
+void arena_destroy(struct arena*);
@@ -0,0 +1,72 @@
+#!/usr/bin/perl -w
+
+# Generate usys.S, the stubs for syscalls.
+
+print "# generated by usys.pl - do not edit\n";
+
+print "#include \"kernel/syscall.h\"\n";
+
+sub entry {
+    my $name = shift;
+    print ".global $name\n";
+    print "${name}:\n";
+    print " li a7, SYS_${name}\n";
+    print " ecall\n";
+    print " ret\n";
+}
+
+# labx printf
+# printf.c 要在这些系统调用之前刷输出缓冲区：桩同时叫 _name 和 name，
+# name 是弱符号，链接了 printf.o 时被 printf.c 里的同名函数盖掉。
+sub wrapped {
+    my $name = shift;
+    print ".global _${name}\n";
+    print ".weak ${name}\n";
+    print "_${name}:\n";
+    print "${name}:\n";
+    print " li a7, SYS_${name}\n";
+    print " ecall\n";
+    print " ret\n";
+}
+	
+wrapped("fork");
+wrapped("exit");
+entry("wait");
+entry("pipe");
+entry("read");
+entry("write");
+wrapped("close");
+entry("kill");
+wrapped("exec");
+entry("open");
+entry("mknod");
+entry("unlink");
+entry("fstat");
+entry("link");
+entry("mkdir");
+entry("chdir");
+entry("dup");
+entry("getpid");
+entry("sbrk");
+entry("sleep");
+entry("uptime");
+entry("trace");
+entry("sysinfo");
+entry("pgaccess");
+entry("clone");
+entry("join");
+entry("futex_wait");
+entry("futex_wake");
+wrapped("spawn");
+entry("pipe2");
+entry("splice");
+entry("chan_create");
+entry("readv");
+entry("writev");
+entry("poll");
+entry("eventfd");
+entry("getdents");
+entry("setaffinity");
+entry("iostat");
+entry("hmkdir");
+entry("dcstat");
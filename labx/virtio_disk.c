@@ -0,0 +1,418 @@
+//
+// driver for qemu's virtio disk device.
+// uses qemu's mmio interface to virtio.
+// qemu presents a "legacy" virtio interface.
+//
+// qemu ... -drive file=fs.img,if=none,format=raw,id=x0 -device virtio-blk-device,drive=x0,bus=virtio-mmio-bus.0
+//
+
+#include "types.h"
+#include "riscv.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+#include "virtio.h"
+#include "iostat.h"
+
+// the address of virtio mmio register r.
+#define R(r) ((volatile uint32 *)(VIRTIO0 + (r)))
+
+static struct disk {
+ // memory for virtio descriptors &c for queue 0.
+ // this is a global instead of allocated because it must
+ // be multiple contiguous pages, which kalloc()
+ // doesn't support, and page aligned.
+  char pages[2*PGSIZE];
+  struct virtq_desc *desc;
+  struct virtq_avail *avail;
+  struct virtq_used *used;
+
+  // our own book-keeping.
+  char free[NUM];  // is a descriptor free?
+  uint16 used_idx; // we've looked this far in used[2..NUM].
+
+  // track info about in-flight operations,
+  // for use when completion interrupt arrives.
+  // indexed by first descriptor index of chain.
+  // labx: b 是请求里的第一个 buf，其余的用 qnext 串在后面。
+  struct {
+    struct buf *b;
+    char status;
+  } info[NUM];
+
+  // disk command headers.
+  // one-for-one with descriptors, for convenience.
+  struct virtio_blk_req ops[NUM];
+
+  // labx elevator
+  struct buf *queue; // 还没发给设备的 buf，按 blockno 排序
+  uint headpos;      // 上一个请求结束的块号，C-SCAN 从这里往后发
+  int pending;       // 已经放进 avail 环、还没通知设备的请求数
+  struct iostat st;
+  
+  struct spinlock vdisk_lock;
+  
+} __attribute__ ((aligned (PGSIZE))) disk;
+
+void
+virtio_disk_init(void)
+{
+  uint32 status = 0;
+
+  initlock(&disk.vdisk_lock, "virtio_disk");
+
+  if(*R(VIRTIO_MMIO_MAGIC_VALUE) != 0x74726976 ||
+     *R(VIRTIO_MMIO_VERSION) != 1 ||
+     *R(VIRTIO_MMIO_DEVICE_ID) != 2 ||
+     *R(VIRTIO_MMIO_VENDOR_ID) != 0x554d4551){
+    panic("could not find virtio disk");
+  }
+  
+  status |= VIRTIO_CONFIG_S_ACKNOWLEDGE;
+  *R(VIRTIO_MMIO_STATUS) = status;
+
+  status |= VIRTIO_CONFIG_S_DRIVER;
+  *R(VIRTIO_MMIO_STATUS) = status;
+
+  // negotiate features
+  uint64 features = *R(VIRTIO_MMIO_DEVICE_FEATURES);
+  features &= ~(1 << VIRTIO_BLK_F_RO);
+  features &= ~(1 << VIRTIO_BLK_F_SCSI);
+  features &= ~(1 << VIRTIO_BLK_F_CONFIG_WCE);
+  features &= ~(1 << VIRTIO_BLK_F_MQ);
+  features &= ~(1 << VIRTIO_F_ANY_LAYOUT);
+  features &= ~(1 << VIRTIO_RING_F_EVENT_IDX);
+  features &= ~(1 << VIRTIO_RING_F_INDIRECT_DESC);
+  *R(VIRTIO_MMIO_DRIVER_FEATURES) = features;
+
+  // tell device that feature negotiation is complete.
+  status |= VIRTIO_CONFIG_S_FEATURES_OK;
+  *R(VIRTIO_MMIO_STATUS) = status;
+
+  // tell device we're completely ready.
+  status |= VIRTIO_CONFIG_S_DRIVER_OK;
+  *R(VIRTIO_MMIO_STATUS) = status;
+
+  *R(VIRTIO_MMIO_GUEST_PAGE_SIZE) = PGSIZE;
+
+  // initialize queue 0.
+  *R(VIRTIO_MMIO_QUEUE_SEL) = 0;
+  uint32 max = *R(VIRTIO_MMIO_QUEUE_NUM_MAX);
+  if(max == 0)
+    panic("virtio disk has no queue 0");
+  if(max < NUM)
+    panic("virtio disk max queue too short");
+  *R(VIRTIO_MMIO_QUEUE_NUM) = NUM;
+  memset(disk.pages, 0, sizeof(disk.pages));
+  *R(VIRTIO_MMIO_QUEUE_PFN) = ((uint64)disk.pages) >> PGSHIFT;
+
+  // desc = pages -- num * virtq_desc
+  // avail = pages + 0x40 -- 2 * uint16, then num * uint16
+  // used = pages + 4096 -- 2 * uint16, then num * vRingUsedElem
+
+  disk.desc = (struct virtq_desc *) disk.pages;
+  disk.avail = (struct virtq_avail *)(disk.pages + NUM*sizeof(struct virtq_desc));
+  disk.used = (struct virtq_used *) (disk.pages + PGSIZE);
+
+  // all NUM descriptors start out unused.
+  for(int i = 0; i < NUM; i++)
+    disk.free[i] = 1;
+
+  // plic.c and trap.c arrange for interrupts from VIRTIO0_IRQ.
+}
+
+// find a free descriptor, mark it non-free, return its index.
+static int
+alloc_desc()
+{
+  for(int i = 0; i < NUM; i++){
+    if(disk.free[i]){
+      disk.free[i] = 0;
+      return i;
+    }
+  }
+  return -1;
+}
+
+// mark a descriptor as free.
+static void
+free_desc(int i)
+{
+  if(i >= NUM)
+    panic("free_desc 1");
+  if(disk.free[i])
+    panic("free_desc 2");
+  disk.desc[i].addr = 0;
+  disk.desc[i].len = 0;
+  disk.desc[i].flags = 0;
+  disk.desc[i].next = 0;
+  disk.free[i] = 1;
+}
+
+// free a chain of descriptors.
+static void
+free_chain(int i)
+{
+  while(1){
+    int flag = disk.desc[i].flags;
+    int nxt = disk.desc[i].next;
+    free_desc(i);
+    if(flag & VRING_DESC_F_NEXT)
+      i = nxt;
+    else
+      break;
+  }
+}
+
+// allocate n descriptors (they need not be contiguous).
+// labx: 一个请求是 1 个头 + 每块一个数据描述符 + 1 个状态。
+static int
+alloc_descs(int *idx, int n)
+{
+  for(int i = 0; i < n; i++){
+    idx[i] = alloc_desc();
+    if(idx[i] < 0){
+      for(int j = 0; j < i; j++)
+        free_desc(idx[j]);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// labx elevator
+// 请求先按 blockno 排进 disk.queue，kick() 的时候才发给设备：
+// 从 headpos 往后 (到头了再从最小的块号开始) 取一段块号连续、
+// 方向相同的 buf，最多 MAXSEG 个，合成一个多段的 virtio 请求。
+// 描述符不够时剩下的留在队列里，中断里释放描述符后接着发。
+
+#define MAXSEG 8
+
+// 把 n 个块号连续的 buf (从 b 开始用 qnext 串着) 作为一个请求放进 avail 环。
+static void
+start(struct buf *b, int n, int write, int *idx)
+{
+  struct buf *x;
+  int i;
+
+  // the spec's Section 5.2 says that legacy block operations use
+  // three descriptors: one for type/reserved/sector, one for the
+  // data, one for a 1-byte status result.
+  // labx: 数据可以分成多个描述符，这里每块一个。
+
+  // format the descriptors.
+  // qemu's virtio-blk.c reads them.
+
+  struct virtio_blk_req *buf0 = &disk.ops[idx[0]];
+
+  if(write)
+    buf0->type = VIRTIO_BLK_T_OUT; // write the disk
+  else
+    buf0->type = VIRTIO_BLK_T_IN; // read the disk
+  buf0->reserved = 0;
+  buf0->sector = (uint64)b->blockno * (BSIZE / 512);
+
+  disk.desc[idx[0]].addr = (uint64) buf0;
+  disk.desc[idx[0]].len = sizeof(struct virtio_blk_req);
+  disk.desc[idx[0]].flags = VRING_DESC_F_NEXT;
+  disk.desc[idx[0]].next = idx[1];
+
+  for(i = 1, x = b; i <= n; i++, x = x->qnext){
+    disk.desc[idx[i]].addr = (uint64) x->data;
+    disk.desc[idx[i]].len = BSIZE;
+    if(write)
+      disk.desc[idx[i]].flags = 0; // device reads b->data
+    else
+      disk.desc[idx[i]].flags = VRING_DESC_F_WRITE; // device writes b->data
+    disk.desc[idx[i]].flags |= VRING_DESC_F_NEXT;
+    disk.desc[idx[i]].next = idx[i+1];
+  }
+
+  disk.info[idx[0]].status = 0xff; // device writes 0 on success
+  disk.desc[idx[n+1]].addr = (uint64) &disk.info[idx[0]].status;
+  disk.desc[idx[n+1]].len = 1;
+  disk.desc[idx[n+1]].flags = VRING_DESC_F_WRITE; // device writes the status
+  disk.desc[idx[n+1]].next = 0;
+
+  // record struct buf for virtio_disk_intr().
+  disk.info[idx[0]].b = b;
+
+  // tell the device the first index in our chain of descriptors.
+  disk.avail->ring[disk.avail->idx % NUM] = idx[0];
+
+  __sync_synchronize();
+
+  // tell the device another avail ring entry is available.
+  disk.avail->idx += 1; // not % NUM ...
+
+  disk.pending++;
+  if(write)
+    disk.st.wreq++;
+  else
+    disk.st.rreq++;
+}
+
+// 按 C-SCAN 的顺序把队列里的请求合并后发出去，直到队列空了或者描述符不够，
+// 最后通知一次设备。调用者持有 disk.vdisk_lock。
+static void
+kick(void)
+{
+  struct buf **pp, *first, *last;
+  int n, idx[MAXSEG+2];
+
+  while(disk.queue){
+    for(pp = &disk.queue; *pp && (*pp)->blockno < disk.headpos; pp = &(*pp)->qnext)
+      ;
+    if(*pp == 0)
+      pp = &disk.queue;
+    first = last = *pp;
+    n = 1;
+    while(n < MAXSEG && last->qnext && last->qnext->blockno == last->blockno + 1 &&
+          last->qnext->qwrite == first->qwrite){
+      last = last->qnext;
+      n++;
+    }
+    if(alloc_descs(idx, n+2) < 0)
+      break;
+    *pp = last->qnext;
+    last->qnext = 0;
+    start(first, n, first->qwrite, idx);
+    disk.headpos = last->blockno + 1;
+  }
+
+  if(disk.pending == 0)
+    return;
+  __sync_synchronize();
+  *R(VIRTIO_MMIO_QUEUE_NOTIFY) = 0; // value is queue number
+  disk.pending = 0;
+  disk.st.kicks++;
+}
+
+// 把 b 按 blockno 排进队列，不通知设备。
+// 完成时中断里调用 done(b)，done 为 0 时 wakeup(b)。
+// 调用者持有 disk.vdisk_lock。
+static void
+submit(struct buf *b, int write, void (*done)(struct buf *))
+{
+  struct buf **pp;
+
+  b->disk = 1;
+  b->done = done;
+  b->qwrite = write;
+  for(pp = &disk.queue; *pp && (*pp)->blockno < b->blockno; pp = &(*pp)->qnext)
+    ;
+  b->qnext = *pp;
+  *pp = b;
+  if(write)
+    disk.st.wblocks++;
+  else
+    disk.st.rblocks++;
+}
+
+void
+virtio_disk_rw(struct buf *b, int write)
+{
+  acquire(&disk.vdisk_lock);
+
+  submit(b, write, 0);
+  kick();
+
+  // Wait for virtio_disk_intr() to say request has finished.
+  // 描述符由 virtio_disk_intr() 释放。
+  while(b->disk == 1) {
+    sleep(b, &disk.vdisk_lock);
+  }
+
+  release(&disk.vdisk_lock);
+}
+
+// labx: 异步接口。virtio_disk_submit() 只把请求排进队列，
+// 攒几个之后 virtio_disk_kick() 一次通知设备；
+// done 不为 0 的请求完成时在中断里调用 done(b)，否则用 virtio_disk_wait(b) 等。
+// 请求完成前 b 不能被别人改，通常由调用者拿着 b 的 sleeplock。
+void
+virtio_disk_submit(struct buf *b, int write, void (*done)(struct buf *))
+{
+  acquire(&disk.vdisk_lock);
+  submit(b, write, done);
+  release(&disk.vdisk_lock);
+}
+
+void
+virtio_disk_kick(void)
+{
+  acquire(&disk.vdisk_lock);
+  kick();
+  release(&disk.vdisk_lock);
+}
+
+void
+virtio_disk_wait(struct buf *b)
+{
+  acquire(&disk.vdisk_lock);
+  kick();
+  while(b->disk == 1) {
+    sleep(b, &disk.vdisk_lock);
+  }
+  release(&disk.vdisk_lock);
+}
+
+void
+virtio_disk_intr()
+{
+  acquire(&disk.vdisk_lock);
+
+  // the device won't raise another interrupt until we tell it
+  // we've seen this interrupt, which the following line does.
+  // this may race with the device writing new entries to
+  // the "used" ring, in which case we may process the new
+  // completion entries in this interrupt, and have nothing to do
+  // in the next interrupt, which is harmless.
+  *R(VIRTIO_MMIO_INTERRUPT_ACK) = *R(VIRTIO_MMIO_INTERRUPT_STATUS) & 0x3;
+
+  __sync_synchronize();
+
+  // the device increments disk.used->idx when it
+  // adds an entry to the used ring.
+
+  while(disk.used_idx != disk.used->idx){
+    __sync_synchronize();
+    int id = disk.used->ring[disk.used_idx % NUM].id;
+
+    if(disk.info[id].status != 0)
+      panic("virtio_disk_intr status");
+
+    struct buf *b = disk.info[id].b, *nb;
+    disk.info[id].b = 0;
+    free_chain(id);
+    for(; b; b = nb){
+      nb = b->qnext;
+      b->qnext = 0;
+      b->disk = 0;   // disk is done with buf
+      if(b->done)
+        b->done(b);
+      else
+        wakeup(b);
+    }
+
+    disk.used_idx += 1;
+  }
+
+  // labx elevator: 描述符空出来了，接着发队列里剩下的
+  kick();
+
+  release(&disk.vdisk_lock);
+}
+
+// labx iostat
+void
+virtio_disk_stat(struct iostat *st)
+{
+  acquire(&disk.vdisk_lock);
+  *st = disk.st;
+  release(&disk.vdisk_lock);
+}
@@ -0,0 +1,133 @@
+#include "kernel/types.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+#define STDIN 0
+#define STDOUT 1
+#define STDERR 2
+
+/*
+管道实现的是将前面的stdout作为后面的stdin
+但是有些命令不接受管道的传递方式，最常见的就是ls命令
+有些时候命令希望管道传递的是参数，但是直接用管道有时无法传递到命令的参数位
+这时候需要xargs，xargs实现的是将管道传输过来的stdin进行处理然后传递到命令的参数位上
+也就是说xargs完成了两个行为：处理管道传输过来的stdin；将处理后的传递到正确的位置上。
+
+such as :
+$ ls
+这会在 stdout 打印当前目录下的文件和目录
+$ echo .. | ls
+这仍然打印当前目录，虽然我们的理想是打印 ls ..，即上层目录
+但是管道将 echo 的 stdout 作为 ls 的 stdin，然而 ls 不接受管道的传递方式
+$ echo .. | xargs ls ..
+这时候接可以看到上层目录的东西了
+因为 xargs 将关东传输过来的 stdin 转换为了命令行参数 argv 传递给 ls
+*/
+
+// labx xargs -n/-P
+// -n N：每条命令最多带 N 个输入项 (默认 1，和原来一样一行一条命令)，
+//       连同命令本身的参数不超过 MAXARG-1 个，exec 要留一个位置给结尾的 0
+// -P N：最多同时运行 N 条命令 (默认 1)，满了就 wait() 一个再启动下一个
+static void usage(void) {
+    fprintf(2, "usage: xargs [-n N] [-P N] command [args ...]\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+
+    char *exec_argv[MAXARG + 1];
+    int maxitems = 1, maxprocs = 1, running = 0, failed = 0;
+
+    // 先处理 xargs 自己的选项
+    int i = 1;
+    while (i + 1 < argc && argv[i][0] == '-') {
+        if (!strcmp(argv[i], "-n")) {
+            maxitems = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "-P")) {
+            maxprocs = atoi(argv[i + 1]);
+        } else {
+            break;
+        }
+        i += 2;
+    }
+    if (i >= argc) {
+        usage();
+    }
+
+    // 再获取要执行的命令和它自己的参数
+    int nfixed = 0;
+    for (; i < argc; ++ i) {
+        if (nfixed >= MAXARG - 2) {     // 至少留一个输入项和结尾的 0
+            usage();
+        }
+        exec_argv[nfixed ++] = argv[i];
+    }
+    if (maxitems < 1) {
+        maxitems = 1;
+    }
+    if (maxitems > MAXARG - 1 - nfixed) {
+        maxitems = MAXARG - 1 - nfixed;
+    }
+    if (maxprocs < 1) {
+        maxprocs = 1;
+    }
+
+    /*  这里必须要循环读取
+        因为有个案例是 find . b | xargs grep hello
+    */
+    while (1) {
+
+        // 再从管道中获取上一级的 stdout，攒够 maxitems 个输入项
+        // labx getline: 一次 read 读进 4K 再按行取，不再逐字节 read；
+        // 行复制到 arena 里，命令启动之后一起释放；超过 4K 的行被 getline 拆成几项
+        struct arena *a = arena_create();
+        if (a == 0) {
+            fprintf(2, "xargs: out of memory\n");
+            exit(1);
+        }
+        int idx = nfixed;
+        char *line;
+        int len;
+        while (idx - nfixed < maxitems && (len = getline(STDIN, &line)) > 0) {
+            if (line[len - 1] == '\n') {
+                line[-- len] = '\0';
+            }
+            char *item = arena_alloc(a, len + 1);
+            if (item == 0) {
+                fprintf(2, "xargs: out of memory\n");
+                exit(1);
+            }
+            strcpy(item, line);
+            // 将 stdin 参数拼接到 exec_argv 后面
+            exec_argv[idx ++] = item;
+        }
+
+        if (idx == nfixed) {
+            arena_destroy(a);
+            break;
+        }
+        exec_argv[idx] = 0;
+
+        // 已经有 maxprocs 条命令在跑，先等一条结束
+        if (running == maxprocs) {
+            wait(0);
+            running --;
+        }
+
+        // labx spawn: 不用 fork + exec，省掉复制 xargs 自己的地址空间
+        // spawn 返回时参数已经复制进子进程，arena 可以马上释放
+        int pid = spawn(exec_argv[0], exec_argv, 0, 0);
+        arena_destroy(a);
+        if(pid < 0) {
+            fprintf(2, "xargs: cannot run %s\n", exec_argv[0]);
+            failed = 1;
+            break;
+        }
+        running ++;
+    }
+
+    while (running -- > 0) {
+        wait(0);
+    }
+    exit(failed);
+}